@@ -58,7 +58,7 @@ ord_t    mad_ctpsa_ord     (const ctpsa_t *t, log_t   hi_ ); // get mo or hi
 log_t    mad_ctpsa_isnul   (const ctpsa_t *t);
 log_t    mad_ctpsa_isval   (const ctpsa_t *t);
 log_t    mad_ctpsa_isvalid (const ctpsa_t *t);
-num_t    mad_ctpsa_density (const ctpsa_t *t, num_t stat_[2], log_t reset); // ratio nz/nc in [0] U [lo,hi] or stat
+num_t    mad_ctpsa_density (const ctpsa_t *t, num_t stat_[4], log_t reset); // ratio nz/nc in [0] U [lo,hi] or stat (mu,sig,#prn coefs,#prn ords)
 
 // initialization / manipulation
 void     mad_ctpsa_copy    (const ctpsa_t *t, ctpsa_t *r);
@@ -129,6 +129,7 @@ void     mad_ctpsa_dif     (const ctpsa_t *a, const ctpsa_t *b, ctpsa_t *c); //
 void     mad_ctpsa_add     (const ctpsa_t *a, const ctpsa_t *b, ctpsa_t *c);
 void     mad_ctpsa_sub     (const ctpsa_t *a, const ctpsa_t *b, ctpsa_t *c);
 void     mad_ctpsa_mul     (const ctpsa_t *a, const ctpsa_t *b, ctpsa_t *c);
+void     mad_ctpsa_mulord  (const ctpsa_t *a, const ctpsa_t *b, ctpsa_t *c, ord_t lo, ord_t hi); // orders [lo,hi] of a*b
 void     mad_ctpsa_div     (const ctpsa_t *a, const ctpsa_t *b, ctpsa_t *c);
 void     mad_ctpsa_pow     (const ctpsa_t *a, const ctpsa_t *b, ctpsa_t *c);
 void     mad_ctpsa_powi    (const ctpsa_t *a,       int      n, ctpsa_t *c);
@@ -204,6 +205,19 @@ void     mad_ctpsa_poisbra (const ctpsa_t *a, const ctpsa_t *b, ctpsa_t *c, int
 void     mad_ctpsa_taylor  (const ctpsa_t *a, ssz_t n, const cpx_t coef[], ctpsa_t *c);
 void     mad_ctpsa_taylor_h(const ctpsa_t *a, ssz_t n, const cpx_t coef[], ctpsa_t *c); // Horner
 
+// batched functions over GTPSAs sharing the same descriptor (parallel over
+// items), aliasing is only allowed between a[i] and c[i]
+void     mad_ctpsa_vinv    (ssz_t n, const ctpsa_t *a[], cpx_t v, ctpsa_t *c[]); // c[i] = v/a[i]
+void     mad_ctpsa_vinvsqrt(ssz_t n, const ctpsa_t *a[], cpx_t v, ctpsa_t *c[]); // c[i] = v/sqrt(a[i])
+void     mad_ctpsa_vsqrt   (ssz_t n, const ctpsa_t *a[], ctpsa_t *c[]);
+void     mad_ctpsa_vexp    (ssz_t n, const ctpsa_t *a[], ctpsa_t *c[]);
+void     mad_ctpsa_vlog    (ssz_t n, const ctpsa_t *a[], ctpsa_t *c[]);
+void     mad_ctpsa_vsin    (ssz_t n, const ctpsa_t *a[], ctpsa_t *c[]);
+void     mad_ctpsa_vcos    (ssz_t n, const ctpsa_t *a[], ctpsa_t *c[]);
+void     mad_ctpsa_vsincos (ssz_t n, const ctpsa_t *a[], ctpsa_t *s[], ctpsa_t *c[]);
+void     mad_ctpsa_vinv_r    (ssz_t n, const ctpsa_t *a[], num_t v_re, num_t v_im, ctpsa_t *c[]);
+void     mad_ctpsa_vinvsqrt_r(ssz_t n, const ctpsa_t *a[], num_t v_re, num_t v_im, ctpsa_t *c[]);
+
 // functions for differential algebra with internal real-to-complex conversion
 void     mad_ctpsa_poisbrat(const ctpsa_t *a, const  tpsa_t *b, ctpsa_t *c, int nv);
 void     mad_ctpsa_tpoisbra(const  tpsa_t *a, const ctpsa_t *b, ctpsa_t *c, int nv);
@@ -268,6 +282,7 @@ num_t    mad_ctpsa_mnrm     (ssz_t na, const ctpsa_t *ma[]);
 void     mad_ctpsa_minv     (ssz_t na, const ctpsa_t *ma[], ssz_t nb,                      ctpsa_t *mc[]);
 void     mad_ctpsa_pminv    (ssz_t na, const ctpsa_t *ma[], ssz_t nb,                      ctpsa_t *mc[], idx_t select[]);
 void     mad_ctpsa_compose  (ssz_t na, const ctpsa_t *ma[], ssz_t nb, const ctpsa_t *mb[], ctpsa_t *mc[]);
+void     mad_ctpsa_compose_n(ssz_t na, const ctpsa_t *ma[], ssz_t nb, ssz_t n,             ctpsa_t *mc[]); // ma[n*nb]
 void     mad_ctpsa_translate(ssz_t na, const ctpsa_t *ma[], ssz_t nb, const cpx_t    tb[], ctpsa_t *mc[]);
 void     mad_ctpsa_eval     (ssz_t na, const ctpsa_t *ma[], ssz_t nb, const cpx_t    tb[], cpx_t    tc[]);
 void     mad_ctpsa_mconv    (ssz_t na, const ctpsa_t *ma[], ssz_t nc,                      ctpsa_t *mc[], ssz_t n, idx_t t2r_[], int pb);
@@ -279,6 +294,13 @@ const
 desc_t*  mad_ctpsa_scan_hdr (      int *kind_, char  name_[NAMSZ],                  FILE *stream_);
 void     mad_ctpsa_scan_coef(      ctpsa_t *t,                                      FILE *stream_);
 
+// binary I/O (load from memory, e.g. mapped file)
+void     mad_ctpsa_save     (const ctpsa_t *t, str_t name_,                         FILE *stream_);
+ctpsa_t* mad_ctpsa_load     (                       ptr_t buf, size_t len, size_t *pos);
+const
+desc_t*  mad_ctpsa_load_hdr (      int *kind_, char  name_[NAMSZ], ptr_t buf, size_t len, size_t pos);
+void     mad_ctpsa_load_coef(      ctpsa_t *t,                     ptr_t buf, size_t len, size_t *pos);
+
 // unsafe operation (mo vs allocated!!)
 ctpsa_t* mad_ctpsa_init     (      ctpsa_t *t, const desc_t *d, ord_t mo);
 
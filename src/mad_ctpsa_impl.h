@@ -43,6 +43,7 @@ struct ctpsa_ { // warning: must be identical to LuaJIT def (see mad_gtpsa.mad)
 
 #define T                ctpsa_t
 #define NUM              cpx_t
+#define ACC              cpx_t  // accumulator of products in kernels
 #define NUMF(name)       MKNAME(mad_cpx_,name)
 #define FUN(name)        MKNAME(mad_ctpsa_,name)
 #define PFX(name)        MKNAME(c,name)
@@ -144,6 +145,34 @@ mad_ctpsa_nzero0r (const ctpsa_t *t, ord_t lo, ord_t hi, log_t upt)
   return -1;
 }
 
+static inline void // prune coefs below thresholds of each order and adjust lo,hi
+mad_ctpsa_prune0 (ctpsa_t *t)
+{
+  assert(t);
+  const num_t *eps = t->d->prn;
+  if (!eps || t->lo > t->hi) return;    // pruning disabled or scalar
+
+  const idx_t *o2i = t->d->ord2idx;
+  ord_t lo = t->lo, hi = t->hi;
+  long n = 0;
+  for (ord_t o = lo; o <= hi; ++o) {
+    num_t e = eps[o];
+    if (e > 0)
+      for (idx_t i = o2i[o]; i < o2i[o+1]; ++i)
+        if (t->coef[i] && fabs(t->coef[i]) < e) t->coef[i] = 0, ++n;
+  }
+  if (!n) return;
+
+  if (mad_ctpsa_nzero0(t,lo,hi,1) >= 0) mad_ctpsa_nzero0r(t,t->lo,hi,1);
+
+  desc_t *d = (desc_t*)t->d;
+  num_t no = (hi-lo+1) - (t->lo <= t->hi ? t->hi-t->lo+1 : 0); // dropped orders
+  #pragma omp atomic
+  d->prn_n += n;
+  #pragma omp atomic
+  d->prn_o += no;
+}
+
 // --- temporaries ------------------------------------------------------------o
 
 #if DESC_USE_TMP
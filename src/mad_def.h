@@ -41,6 +41,7 @@ typedef int32_t          ssz_t;
 typedef uint32_t         u32_t;
 typedef uint64_t         u64_t;
 typedef double           num_t;
+typedef float            flt_t;
 typedef double _Complex  cpx_t;
 typedef const char*      str_t;
 typedef const void*      ptr_t;
@@ -1243,6 +1243,21 @@ mad_desc_paropsth (const D *d, ssz_t *mult_, ssz_t *comp_)
   DBGFUN(<-);
 }
 
+void
+mad_desc_prneps (const D *d, num_t eps, const num_t eps_[])
+{
+  assert(d); DBGFUN(->);
+  D *dd = (D*)d;
+  log_t on = FALSE;
+  if (!dd->prn) dd->prn = mad_malloc((d->mo+1) * sizeof *dd->prn);
+  FOR(o,d->mo+1) {
+    dd->prn[o] = o ? eps_ ? eps_[o] : eps : 0; // never prune order 0
+    on |= dd->prn[o] > 0;
+  }
+  if (!on) mad_free(dd->prn), dd->prn = NULL;
+  DBGFUN(<-);
+}
+
 void
 mad_desc_info (const D *d, FILE *fp_)
 {
@@ -1353,6 +1368,7 @@ mad_desc_del (const D *d_)
 
   mad_free((void*)d->no);
   mad_free(d->prms);
+  mad_free(d->prn);
 
   if (*d->shared > 0) --*d->shared;
   else {
@@ -84,6 +84,9 @@ ord_t mad_desc_mono      (const desc_t *d, idx_t i, ssz_t n,       ord_t m_[], o
 // parallelised operations thresholds, e.g. multiplication and composition (0 = disable)
 void  mad_desc_paropsth  (const desc_t *d, ssz_t *mult_, ssz_t *comp_); // return previous values
 
+// coefficients pruning after arithmetic, |coef| < eps_[o] (or eps) zeroed (0 = disable)
+void  mad_desc_prneps    (const desc_t *d, num_t eps, const num_t eps_[]); // eps_[0..mo]
+
 // for debugging
 void  mad_desc_info      (const desc_t *d, FILE *fp_);
 
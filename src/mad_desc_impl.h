@@ -54,6 +54,7 @@ struct desc_ { // warning: must be identical to LuaJIT def (see mad_gtpsa.mad)
   int   uno, nth;    // user provided no, max #threads or 1
   ssz_t nc;          // number of coefs (max length of TPSA)
   ssz_t pmul, pcomp; // thresholds for parallel mult and compose (0 = disable)
+  num_t *prn;        // thresholds of coefs pruning per order (null = disable)
 
   int   *shared;     // counter of shared desc (all tables below except prms)
   ord_t *monos,      // 'matrix' storing the monomials (sorted by var)
@@ -74,7 +75,9 @@ struct desc_ { // warning: must be identical to LuaJIT def (see mad_gtpsa.mad)
 
   num_t dst_n,       // density count
         dst_mu,      // density mean
-        dst_var;     // density variance
+        dst_var,     // density variance
+        prn_n,       // pruned coefs count
+        prn_o;       // pruned orders count
 
   // permanent temporaries per thread for internal use (not shared)
 #if DESC_USE_TMP
@@ -23,6 +23,7 @@
 
 // --- includes ---------------------------------------------------------------o
 
+#include <cstring>
 #include <type_traits>
 #include "mad_tpsa.hpp"
 
@@ -30,7 +31,9 @@ extern "C" {
 #include "mad_log.h"
 #include "mad_cst.h"
 #include "mad_mem.h"
+#include "mad_vec.h"
 #include "mad_mat.h"
+#include "mad_rad.h"
 #include "mad_dynmap.h"
 }
 
@@ -81,6 +84,28 @@ struct cflw { // must be identical to def of 3 variants in madl_etck.mad!!
   MP  bfx[snm_max];
   MP  bfy[snm_max];
 
+// end of polymorphic section
+
+  // beam-beam, strong beam
+  int   nbbsl;                  // number of slices (6D)
+  bool  kckorb;                 // kick the orbit
+  num_t bbnq, bbbeta, sigtol;   // npart*charge*dir, beta, round beam tolerance
+  num_t xma, yma, dpx, dpy;     // position, momenta offsets
+  num_t bbsig[6];               // x2, xx', x'2, y2, yy', y'2 at the IP
+  num_t *bbsl;                  // slices [nbbsl][z, weight]
+
+  // synchrotron radiation
+  num_t gamma, emrad, aphot;    // beam gamma, classical radius, photons/rad
+  num_t kcrit, rdfac;           // critical energy factor, slice weight (damp)
+  u32_t turn, elem;             // streams selection (quant)
+  crng_state_t *rng;            // streams key (quant)
+  idx_t *rdid;                  // particles ids [npar] (quant)
+  num_t *rdsnp;                 // snapshots [id][x, px, py] (quant)
+  num_t *rdloss;                // relative energy loss [npar] (quant, out)
+  idx_t *rdnph;                 // number of photons [npar] (quant, out)
+  phbuf_t *phb;                 // photons buffer, emission s-position (photon)
+  num_t    phs;
+
   // particles/damaps/parametric_damaps (must be last!!)
   int npar;
   MT **par;
@@ -241,6 +266,93 @@ inline void bxbyh (const cflw<M> &m, const V &x, const V &y, T &bx, T &by)
   by += bty + R(m.bfy[k+1]);
 }
 
+// --- curved multipoles ------------------------------------------------------o
+
+#include "mad_curvmul.hpp"
+
+// bfx, bfy from knl, ksl and eh, same as getanbnr in madl_curvmul.mad.
+// Results are cached by strengths, e.g. for series of identical dipoles.
+
+struct cmcache {
+  bool  set;
+  int   nmul, snm;
+  num_t eh;
+  num_t knl[nmul_max], ksl[nmul_max];
+  num_t bfx[snm_max] , bfy[snm_max];
+};
+
+static thread_local cmcache cmc[16];
+
+static inline int cm_nc (int no, int ic)
+{
+  int n = no+1-ic;
+  return n*(n+1)/2;
+}
+
+template <typename M>
+inline void curvmul (cflw<M> &m, int snm, int damo)
+{
+  static_assert(std::is_same<typename M::MP, num_t>::value,
+                "curved multipoles with parametric strengths are set in Lua");
+  const int nmul = m.nmul;
+
+  if (nmul == 1 && m.ksl[0] == 0) { m.snm = 0; return; }
+
+  snm = MIN(nmul_max, snm == -1 ? MAX(damo+1, nmul+2) :
+                      snm == -2 ?     damo+1+ nmul    : snm);
+  m.snm = snm;
+
+  const num_t eh = m.edir*m.eh;
+  const int   nc = cm_nc(snm,0);
+
+  // lookup in cache
+  u64_t h = 14695981039346656037ull; // FNV-1a
+#define KEY(v) (h = (h ^ (v)) * 1099511628211ull)
+  KEY((u64_t)nmul), KEY((u64_t)snm);
+  u64_t u; memcpy(&u, &eh, sizeof u), KEY(u);
+  FOR(i,nmul) {
+    memcpy(&u, &m.knl[i], sizeof u), KEY(u);
+    memcpy(&u, &m.ksl[i], sizeof u), KEY(u);
+  }
+#undef KEY
+  cmcache &c = cmc[(h ^ (h >> 32)) % (sizeof cmc/sizeof *cmc)];
+
+  if (c.set && c.nmul == nmul && c.snm == snm && c.eh == eh &&
+      !memcmp(c.knl, m.knl, nmul*sizeof *c.knl) &&
+      !memcmp(c.ksl, m.ksl, nmul*sizeof *c.ksl)) {
+    memcpy(m.bfx, c.bfx, nc*sizeof *m.bfx);
+    memcpy(m.bfy, c.bfy, nc*sizeof *m.bfy);
+    return;
+  }
+
+  // compute coefficients
+  num_t ehn[nmul_max];
+  FOR(n,snm) ehn[n] = pow(eh, n);
+  FOR(i,nc ) m.bfx[i] = m.bfy[i] = 0;
+
+  FOR(i,nmul) {
+    const num_t kn = m.knl[i], ks = m.ksl[i];
+    if (fabs(kn)+fabs(ks) == 0) continue;
+
+    FOR(e,curvmul_idx[i],curvmul_idx[i+1]) {
+      const struct cmcoef &cf = curvmul_coef[e];
+      const int k = cf.i+cf.j;
+      if (i <= k && k < snm) {
+        const int idx = cm_nc(snm, cf.i) - cf.j - 1;
+        m.bfx[idx] += (ks*cf.ax + kn*cf.bx) * ehn[k-i];
+        m.bfy[idx] += (ks*cf.ay + kn*cf.by) * ehn[k-i];
+      }
+    }
+  }
+
+  // save in cache
+  c.set = true, c.nmul = nmul, c.snm = snm, c.eh = eh;
+  memcpy(c.knl, m.knl, nmul*sizeof *c.knl);
+  memcpy(c.ksl, m.ksl, nmul*sizeof *c.ksl);
+  memcpy(c.bfx, m.bfx, nc*sizeof *c.bfx);
+  memcpy(c.bfy, m.bfy, nc*sizeof *c.bfy);
+}
+
 // --- patches ----------------------------------------------------------------o
 
 template <typename M, typename T=M::T, typename P=M::P, typename R=M::R, typename V>
@@ -451,20 +563,67 @@ inline void misalign (cflw<M> &m, num_t lw)
   else         misalignexi<M>(m);
 }
 
+// scratch 1/pz of the damaps, kept per thread between slices and rebuilt when
+// the descriptor or the order change (i.e. the length of the coefficients).
+
+struct pzbuf {
+  std::vector<tpsa_t*> t;
+  std::vector<ssz_t>   nc;
+  ~pzbuf() { for (tpsa_t *a : t) mad_tpsa_del(a); }
+
+  tpsa_t* get (idx_t i, const tpsa_t *a) { // same as a
+    if (t.size() <= size_t(i)) t.resize(i+1, nullptr), nc.resize(i+1, 0);
+    const desc_t *d = mad_tpsa_desc(a);
+    ord_t mo = mad_tpsa_ord(a, false);
+    ssz_t l  = mad_desc_maxlen(d, mo);
+    if (t[i] && (mad_tpsa_desc(t[i]) != d || mad_tpsa_ord(t[i], false) != mo
+                                          || nc[i] != l))
+      mad_tpsa_del(t[i]), t[i] = nullptr;
+    if (!t[i]) t[i] = mad_tpsa_new(a, same), nc[i] = l;
+    return t[i];
+  }
+};
+
+static thread_local pzbuf pzb;
+
+// apply fun(p, 1/pz) to each particle or damap of the flow, for damaps 1/pz
+// is computed by the batched invsqrt (shared temporaries, parallel over maps).
+template <typename M, typename T=M::T, typename F>
+inline void foreach_invpz (cflw<M> &m, F fun)
+{
+  if constexpr (std::is_floating_point<T>::value) {
+    FOR(i,m.npar) {
+      M p(m,i);
+      fun(p, invsqrt(1 + 2/m.beta*p.pt + sqr(p.pt) - sqr(p.px) - sqr(p.py)));
+    }
+  } else {
+    FOR(i,m.npar) {
+      M p(m,i);
+      tpsa_ref{pzb.get(i, p.pt.ptr())} =
+        1 + 2/m.beta*p.pt + sqr(p.pt) - sqr(p.px) - sqr(p.py);
+    }
+    tpsa_t **_pz = pzb.t.data();
+    invsqrt(m.npar, _pz, _pz);
+    FOR(i,m.npar) {
+      M p(m,i);
+      fun(p, tpsa_ref(_pz[i]));
+    }
+  }
+}
+
 // --- special maps -----------------------------------------------------------o
 
 template <typename M, typename T=M::T, typename P=M::P>
 inline void drift_adj (cflw<M> &m, const P &l)
 {
   mdump(0);
-  FOR(i,m.npar) {
-    M p(m,i);
-    T l_pz = l*invsqrt(1 + 2/m.beta*p.pt + sqr(p.pt) - sqr(p.px) - sqr(p.py));
+  foreach_invpz<M>(m, [&](M &p, const auto &_pz) {
+    T l_pz = l*_pz;
 
     p.x += p.px*(l_pz-l);
     p.y += p.py*(l_pz-l);
     p.t  = p.t - (1/m.beta+p.pt)*l_pz + (1-m.T)/m.beta*l;
-  }
+  });
   mdump(1);
 }
 
@@ -479,14 +638,13 @@ inline void strex_drift (cflw<M> &m, num_t lw, int is)
   P l  = R(m.el)*lw;
   P ld = (fval(m.eld) ? R(m.eld) : R(m.el))*lw;
 
-  FOR(i,m.npar) {
-    M p(m,i);
-    T l_pz = l*invsqrt(1 + 2/m.beta*p.pt + sqr(p.pt) - sqr(p.px) - sqr(p.py));
+  foreach_invpz<M>(m, [&](M &p, const auto &_pz) {
+    T l_pz = l*_pz;
 
     p.x += p.px*l_pz;
     p.y += p.py*l_pz;
     p.t  = p.t - (1/m.beta+p.pt)*l_pz + (1-m.T)/m.beta*ld;
-  }
+  });
   mdump(1);
 }
 
@@ -1141,6 +1299,386 @@ inline void rfcav_kickn (cflw<M> &m, num_t lw, int is)
   mdump(1);
 }
 
+// --- beam-beam ---
+
+const num_t bb_wftol = 1e-13; // relative tolerance of batched w(z)
+const num_t bb_qcst  = mad_cst_QELECT/(mad_cst_2PI*mad_cst_EPSILON0)*1e-9;
+
+// scratch of the beam-beam kicks kept per thread between calls, i.e. the
+// arguments z and values w of the batched w(z), the Taylor coefficients c.
+
+struct bbbuf {
+  std::vector<num_t> z, w, c;
+};
+
+static thread_local bbbuf bbb;
+
+// Faddeeva w(z) as (re,im), numbers are batched by the caller using w(z) of
+// bb_wfarg, tpsa are expanded around z0 using w' = -2zw + 2i/sqrt(pi).
+inline void bb_wf (num_t, num_t, num_t &wr, num_t &wi, const num_t *w)
+{
+  wr = w[0], wi = w[1];
+}
+
+template <typename T>
+inline void bb_wf (const T &zr, const T &zi, T &wr, T &wi, const num_t *)
+{
+  ord_t mo = zr.mo();
+  num_t z0r = fval(zr), z0i = fval(zi);
+  std::vector<num_t> &c = bbb.c;
+  c.resize(2*mo+2);
+
+  // Taylor coefficients: (k+1) c[k+1] = -2 z0 c[k] - 2 c[k-1]
+  mad_cpx_wf_r(z0r, z0i, 0, (cpx_t*)c.data());
+  FOR(k,mo) {
+    num_t cr = -2*(z0r*c[2*k] - z0i*c[2*k+1]);
+    num_t ci = -2*(z0r*c[2*k+1] + z0i*c[2*k]);
+    if (k) cr -= 2*c[2*k-2], ci -= 2*c[2*k-1];
+    else   ci += 2*mad_cst_1_SQRTPI;
+    c[2*k+2] = cr/(k+1), c[2*k+3] = ci/(k+1);
+  }
+
+  // complex Horner in dz = z-z0
+  T dr(zr), di(zi), tr(zr);
+  dr = zr - z0r, di = zi - z0i;
+  wr = c[2*mo], wi = c[2*mo+1];
+  RFOR(k,mo) {
+    tr = wr*dr - wi*di + c[2*k];
+    wi = wr*di + wi*dr + c[2*k+1];
+    wr = tr;
+  }
+}
+
+// arguments of w(z) for elliptical beam in the first quadrant, sx2 > sy2
+inline void bb_wfarg (num_t x, num_t y, num_t sx2, num_t sy2, num_t z[4])
+{
+  num_t _S = 1/sqrt(2*(sx2-sy2)), r = sqrt(sy2/sx2);
+  z[0] = x*_S  , z[1] = y*_S;
+  z[2] = z[0]*r, z[3] = z[1]/r;
+}
+
+// h = (1-exp(-u))/u and k = (h-exp(-u))/u, series for small u
+template <typename T>
+inline void bb_hk (const T &u, const T &e, T &h, T &k)
+{
+  if (fval(u) >= 0.5) {
+    h = (1-e)/u;
+    k = (h-e)/u;
+    return;
+  }
+  const int n = 17;             // Horner on (-u)^i/(i+1)! and (i+1)(-u)^i/(i+2)!
+  num_t a = 1;
+  FOR(i,2,n+2) a /= i;
+  num_t b = (n+1)/(n+2.)*a;
+  h = a, k = b;
+  RFOR(i,n) {
+    a *= i+2, b *= (i+1.)*(i+3)/(i+2);
+    h = a - h*u;
+    k = b - k*u;
+  }
+}
+
+// field (Ex,Ey) and its derivatives (Gx,Gy) wrt (sx2,sy2) of a gaussian beam
+// in units of N/(2pi eps0), i.e. Bassetti-Erskine formula for elliptical beam.
+template <typename T, typename Q>
+inline void bb_field (const T &x, const T &y, const Q &sx2, const Q &sy2,
+                      num_t tol, const num_t *w, T &Ex, T &Ey,
+                      T *Gx=nullptr, T *Gy=nullptr)
+{
+  num_t sx = sqrt(fval(sx2)), sy = sqrt(fval(sy2));
+
+  if (fabs(sx-sy) <= tol*(sx+sy)) { // round beam
+    Q q = 1/(sx2+sy2);                // 1/(2 sig^2)
+    T u = q*(sqr(x)+sqr(y));
+    T e = exp(-u), h(u), k(u);
+    bb_hk(u, e, h, k);
+    Ex = q*h*x, Ey = q*h*y;
+    if (Gx) {
+      T g = q*(e - 0.5*h);
+      *Gx = g + sqr(q)*k*sqr(y);
+      *Gy = g + sqr(q)*k*sqr(x);
+    }
+    return;
+  }
+
+  if (sy > sx) { // swap planes
+    bb_field(y, x, sy2, sx2, tol, w, Ey, Ex, Gy, Gx);
+    return;
+  }
+
+  // first quadrant
+  num_t sgx = fval(x) < 0 ? -1 : 1;
+  num_t sgy = fval(y) < 0 ? -1 : 1;
+  Q _S = invsqrt(2*(sx2-sy2)), r = sqrt(sy2/sx2);
+  T ax = sgx*x, ay = sgy*y;
+  T zr = _S*ax, zi = _S*ay, er = r*zr, ei = zi/r;
+  T wzr(zr), wzi(zr), wer(zr), wei(zr);
+
+  bb_wf(zr, zi, wzr, wzi, w);
+  bb_wf(er, ei, wer, wei, w ? w+2 : w);
+
+  Q f = mad_cst_SQRTPI*_S;
+  T e = exp(-0.5*(sqr(ax)/sx2 + sqr(ay)/sy2));
+  Ex = sgx*f*(wzi - wei*e);
+  Ey = sgy*f*(wzr - wer*e);
+
+  if (Gx) {
+    Q c1 = 0.5/(sx2-sy2);
+    T c2 = x*Ex + y*Ey;
+    *Gx = -c1*(c2 + r*e - 1);
+    *Gy =  c1*(c2 + e/r - 1);
+  }
+}
+
+// kick factor of the strong beam on the particle moving with pt, i.e.
+// N Zs Zw e/(2pi eps0 pc) (1+beta beta_s)/(beta+beta_s), head-on collision.
+template <typename M, typename T=M::T, typename V>
+inline T bb_kick (const cflw<M> &m, const V &pt)
+{
+  num_t kq = m.bbnq*m.charge*m.edir*m.sdir*bb_qcst/m.pc;
+  T bet = sqrt(1 + 2/m.beta*pt + sqr(pt))/(1/m.beta + pt);
+  return kq*(1 + bet*m.bbbeta)/(bet + m.bbbeta);
+}
+
+// batch w(z) of all elliptical particles, pos(i,x,y,sx2,sy2) gives the state,
+// return the values of w(z) per particle (4 each) stored in the scratch.
+template <typename M, typename F>
+inline const num_t* bb_wfall (cflw<M> &m, F pos)
+{
+  std::vector<num_t> &z = bbb.z, &w = bbb.w;
+  z.resize(4*m.npar);
+  bool ellip = false;
+
+  FOR(i,m.npar) {
+    num_t x, y, sx2, sy2, *zi = &z[4*i];
+    pos(i, x, y, sx2, sy2);
+    num_t sx = sqrt(sx2), sy = sqrt(sy2);
+    if (fabs(sx-sy) <= m.sigtol*(sx+sy)) { FOR(j,4) zi[j] = 0; continue; }
+    if (sy > sx) std::swap(x, y), std::swap(sx2, sy2);
+    bb_wfarg(fabs(x), fabs(y), sx2, sy2, zi);
+    ellip = true;
+  }
+
+  w.resize(4*m.npar);
+  if (ellip)
+    mad_cvec_wf((const cpx_t*)z.data(), (cpx_t*)w.data(), 2*m.npar, bb_wftol);
+  return w.data();
+}
+
+template <typename M, typename T=M::T>
+inline void bbeam_kick (cflw<M> &m, num_t lw, int is)
+{                                        (void)lw, (void)is;
+  constexpr bool isnum = std::is_floating_point<T>::value;
+  if (!m.bbnq || !m.charge || (isnum && !m.kckorb)) return;
+
+  mdump(0);
+  num_t sx2 = m.bbsig[0], sy2 = m.bbsig[3];
+  const num_t *w = nullptr;
+
+  if constexpr (isnum)
+    w = bb_wfall(m, [&](int i, num_t &x, num_t &y, num_t &x2, num_t &y2) {
+      M p(m,i);
+      x = p.x-m.xma, y = p.y-m.yma, x2 = sx2, y2 = sy2;
+    });
+
+  FOR(i,m.npar) {
+    M p(m,i);
+    T x = p.x-m.xma, y = p.y-m.yma, Ex(x), Ey(x);
+    bb_field(x, y, sx2, sy2, m.sigtol, w ? w+4*i : w, Ex, Ey);
+
+    T kck = bb_kick(m, p.pt);
+    T bpx = kck*Ex, bpy = kck*Ey;
+
+    if constexpr (!isnum) if (!m.kckorb) { // clear orbit kick
+      bpx -= bpx[0];
+      bpy -= bpy[0];
+    }
+
+    p.px += bpx - m.dpx;
+    p.py += bpy - m.dpy;
+  }
+  mdump(1);
+}
+
+// synchro-beam kick (Hirata): each slice of the strong beam kicks at the
+// collision point S = (beta0 t - z)/2 with the beam sizes at S (hourglass).
+template <typename M, typename T=M::T>
+inline void bbeam_kick6D (cflw<M> &m, num_t lw, int is)
+{                                          (void)lw, (void)is;
+  constexpr bool isnum = std::is_floating_point<T>::value;
+  if (!m.bbnq || !m.charge || (isnum && !m.kckorb)) return;
+
+  mdump(0);
+  const num_t *sg = m.bbsig, *w = nullptr;
+
+  FOR(k,m.nbbsl) {
+    num_t zk = m.bbsl[2*k], wk = m.bbsl[2*k+1];
+
+    if constexpr (isnum)
+      w = bb_wfall(m, [&](int i, num_t &x, num_t &y, num_t &x2, num_t &y2) {
+        M p(m,i);
+        num_t S = 0.5*(m.beta*p.t - zk);
+        x  = p.x-m.xma + S*p.px, y  = p.y-m.yma + S*p.py;
+        x2 = sg[0] + S*(2*sg[1] + S*sg[2]);
+        y2 = sg[3] + S*(2*sg[4] + S*sg[5]);
+      });
+
+    FOR(i,m.npar) {
+      M p(m,i);
+      T S = 0.5*(m.beta*p.t - zk);
+      T x = p.x-m.xma + S*p.px, y = p.y-m.yma + S*p.py;
+      T sx2 = sg[0] + S*(2*sg[1] + S*sg[2]);
+      T sy2 = sg[3] + S*(2*sg[4] + S*sg[5]);
+      T Ex(x), Ey(x), Gx(x), Gy(x);
+      bb_field(x, y, sx2, sy2, m.sigtol, w ? w+4*i : w, Ex, Ey, &Gx, &Gy);
+
+      T kck = wk*bb_kick(m, p.pt);
+      T Fx  = kck*Ex, Fy = kck*Ey;
+      T dpt = 0.5*m.beta*(Fx*(p.px + 0.5*Fx) + Fy*(p.py + 0.5*Fy)
+                        + kck*(Gx*2*(sg[1] + S*sg[2]) + Gy*2*(sg[4] + S*sg[5])));
+
+      if constexpr (!isnum) if (!m.kckorb) { // clear orbit kick
+        Fx  -= Fx [0];
+        Fy  -= Fy [0];
+        dpt -= dpt[0];
+      }
+
+      p.pt += dpt;
+      p.px += Fx;
+      p.py += Fy;
+      p.x  -= S*Fx;
+      p.y  -= S*Fy;
+    }
+  }
+
+  FOR(i,m.npar) {
+    M p(m,i);
+    p.px -= m.dpx;
+    p.py -= m.dpy;
+  }
+  mdump(1);
+}
+
+// --- synchrotron radiation --------------------------------------------------o
+
+// average energy loss (PTC-like) from the field of the multipoles, must be
+// identical to M.srad_damp in madl_synrad.mad.
+
+template <typename M, typename T=M::T, typename P=M::P, typename R=M::R>
+inline void srad_damp (cflw<M> &m, num_t lw, int is)
+{                                          (void)is;
+  if ((!m.nmul && !m.snm) || fabs(fval(m.lrad)) < minlen || !m.charge) return;
+
+  mdump(0);
+  const num_t _bet0 = 1/m.beta;
+  const num_t  rfc0 = m.sdir*(2/3.)*m.rdfac*m.emrad*pow(m.gamma,3)*fabs(fval(m.lrad)*lw);
+  const P      _el  = inv(R(m.lrad));
+
+  FOR(i,m.npar) {
+    M p(m,i);
+    T bx(p.x), by(p.y);
+    if (m.snm > 0) bxbyh(m, p.x, p.y, bx, by);
+    else           bxby (m, p.x, p.y, bx, by);
+    bx *= _el, by *= _el;
+
+    T  dp1 = sqrt(1 + 2*_bet0*p.pt + sqr(p.pt));
+    T _dp1 = inv(dp1);
+    T  pz  = sqrt(sqr(dp1) - sqr(p.px) - sqr(p.py));
+    T  ex  = p.px*_dp1;
+    T  ey  = p.py*_dp1;
+    T  be  = bx*ex + by*ey;
+    T  h2  = sqr(bx - be*ex) + sqr(by - be*ey) + sqr(be*pz*_dp1);
+
+    if (fval(h2) > 0) {
+      T opt  = 1+p.pt;
+      T rfac = rfc0*opt*sqr(opt)*h2*(1+R(m.eh)*p.x)/pz;
+      p.pt -= rfac;
+      T pfac = sqrt(1 + 2*_bet0*p.pt + sqr(p.pt))*_dp1;
+      p.px *= pfac;
+      p.py *= pfac;
+    }
+  }
+  mdump(1);
+}
+
+// quantum excitation, the curvature comes from the change of momenta since the
+// snapshot of the previous slice (lw is the length weight in between). Photons
+// are drawn from the stream (id, turn, elem|slice) of each particle, thus the
+// results do not depend on the order nor on the batching of the particles.
+// In photon mode, the emitted photons are appended to the buffer phb.
+// The critical energy scales with the curvature h only, and the mean number
+// of photons with the bending angle h*hlw. The former Lua code had the length
+// on the wrong factor (ucrit ~ h*hlw, nphot ~ h).
+
+static inline int
+srad_nphot (crng_state_t *rng, num_t lmb) // see MP.randp in madl_gmath.mad
+{
+  num_t p = exp(-lmb), s = p, u = mad_num_crand(rng);
+  int   x = 0;
+  while (u > s && p > 0) { ++x; p *= lmb/x; s += p; }
+  return x;
+}
+
+inline void srad_quant (cflw<par_t> &m, num_t lw, int is)
+{
+  if (!m.charge) return;
+
+  mdump(0);
+  const num_t  aelw = fabs(lw);
+  const num_t  eh   = m.eh, bet0 = m.beta, _bet0 = 1/bet0;
+  const u32_t  elem = m.elem << 10 | (is & 1023);
+  enum { nu = 16 };
+
+  FOR(i,m.npar) {
+    par_t p(m,i);
+    num_t *snp = m.rdsnp + 3*(m.rdid[i]-1);
+    num_t  hlw = aelw*(1 + 0.5*eh*(p.x+snp[0]));
+    num_t  rfac = 0;
+    int    nph  = 0;
+
+    if (hlw > 0) {
+      const num_t h = hypot((p.px-snp[1])/hlw - eh, (p.py-snp[2])/hlw);
+
+      if (h > 0) {
+        const num_t  dpp1 = sqrt(1 + 2*_bet0*p.pt + sqr(p.pt));
+        const num_t _beta = (_bet0+p.pt)/dpp1;
+        const num_t  gama = (bet0*p.pt+1)*m.gamma;
+        const num_t ucrit = m.kcrit*sqr(gama)*h;
+
+        crng_state_t rng = *m.rng;
+        mad_num_crandstrm(&rng, m.rdid[i], m.turn, elem);
+        nph = srad_nphot(&rng, m.aphot*dpp1*h*hlw);
+
+        for (int k=0; k < nph; k += nu) { // photons energies by small batches
+          num_t u[nu]; const int n = MIN(nph-k, (int)nu);
+          FOR(j,n) u[j] = mad_num_crand(&rng);
+          mad_rad_InvSynFracIntv(u, u, n);
+          FOR(j,n) rfac += u[j];
+          if (m.phb) { // emitted along the particle direction
+            const num_t nrj = ucrit*m.pc*(_bet0+p.pt), _dpp1 = 1/dpp1;
+            FOR(j,n) if (u[j]*ucrit >= 1e-12)
+              mad_rad_phadd(m.phb, p.x, p.px*_dpp1, p.y, p.py*_dpp1, m.phs,
+                            u[j]*nrj, m.rdid[i], m.turn, m.elem);
+          }
+        }
+
+        if (nph) {
+          rfac *= ucrit;
+          num_t damp = sqrt(1 + rfac*(rfac-2)*sqr(_beta));
+          if (m.sdir < 0) damp = 1/damp, rfac = -rfac;
+          p.px *= damp;
+          p.py *= damp;
+          p.pt  = p.pt*(1-rfac) - rfac*_bet0;
+        }
+      }
+    }
+
+    if (m.rdloss) m.rdloss[i] = rfac, m.rdnph[i] = nph;
+    snp[0] = p.x, snp[1] = p.px, snp[2] = p.py;
+  }
+  mdump(1);
+}
+
 // --- fringe maps ------------------------------------------------------------o
 
 // must be identical to M.fringe in madl_dynmap.mad
@@ -1818,6 +2356,20 @@ void mad_trk_curex_kick_p (mflw_t *m, num_t lw, int is) {
   curex_kick<prm_t>(m->pflw,lw,is);
 }
 
+// --- curved multipoles ---
+
+const struct cmcoef* mad_trk_curvmul_coef (ssz_t *n) {
+  if (n) *n = curvmul_idx[nmul_max];
+  return curvmul_coef;
+}
+
+void mad_trk_curvmul_r (mflw_t *m, int snm, int damo) {
+  curvmul<par_t>(m->rflw,snm,damo);
+}
+void mad_trk_curvmul_t (mflw_t *m, int snm, int damo) {
+  curvmul<map_t>(m->tflw,snm,damo);
+}
+
 // --- sbend ---
 
 void mad_trk_sbend_thick_r (mflw_t *m, num_t lw, int is) {
@@ -1997,6 +2549,46 @@ void mad_trk_rfcav_kickn_p (mflw_t *m, num_t lw, int is) {
   rfcav_kickn<prm_t>(m->pflw,lw,is);
 }
 
+// --- beam-beam ---
+
+void mad_trk_bbeam_kick_r (mflw_t *m, num_t lw, int is) {
+  bbeam_kick<par_t>(m->rflw,lw,is);
+}
+void mad_trk_bbeam_kick6D_r (mflw_t *m, num_t lw, int is) {
+  bbeam_kick6D<par_t>(m->rflw,lw,is);
+}
+
+void mad_trk_bbeam_kick_t (mflw_t *m, num_t lw, int is) {
+  bbeam_kick<map_t>(m->tflw,lw,is);
+}
+void mad_trk_bbeam_kick6D_t (mflw_t *m, num_t lw, int is) {
+  bbeam_kick6D<map_t>(m->tflw,lw,is);
+}
+
+void mad_trk_bbeam_kick_p (mflw_t *m, num_t lw, int is) {
+  bbeam_kick<prm_t>(m->pflw,lw,is);
+}
+void mad_trk_bbeam_kick6D_p (mflw_t *m, num_t lw, int is) {
+  bbeam_kick6D<prm_t>(m->pflw,lw,is);
+}
+
+// --- synchrotron radiation ---
+
+void mad_trk_srad_damp_r (mflw_t *m, num_t lw, int is) {
+  srad_damp<par_t>(m->rflw,lw,is);
+}
+void mad_trk_srad_quant_r (mflw_t *m, num_t lw, int is) {
+  srad_quant(m->rflw,lw,is);
+}
+
+void mad_trk_srad_damp_t (mflw_t *m, num_t lw, int is) {
+  srad_damp<map_t>(m->tflw,lw,is);
+}
+
+void mad_trk_srad_damp_p (mflw_t *m, num_t lw, int is) {
+  srad_damp<prm_t>(m->pflw,lw,is);
+}
+
 // --- do nothing ---
 
 void mad_trk_fnil (mflw_t *m, num_t lw, int is) {
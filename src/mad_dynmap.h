@@ -29,6 +29,8 @@
 typedef union cflw_x mflw_t;
 typedef void (trkfun) (mflw_t*, num_t, int);
 
+struct cmcoef { int mul, i, j; num_t ax, bx, ay, by; }; // see mad_curvmul.hpp
+
 // --- interface --------------------------------------------------------------o
 
 // -- track one slice
@@ -146,16 +148,32 @@ void mad_trk_solen_thick_r  (mflw_t *m, num_t lw, int _);
 void mad_trk_esept_thick_r  (mflw_t *m, num_t lw, int _);
 void mad_trk_rfcav_kick_r   (mflw_t *m, num_t lw, int _);
 void mad_trk_rfcav_kickn_r  (mflw_t *m, num_t lw, int _);
+void mad_trk_bbeam_kick_r   (mflw_t *m, num_t lw, int _);
+void mad_trk_bbeam_kick6D_r (mflw_t *m, num_t lw, int _);
+void mad_trk_srad_damp_r    (mflw_t *m, num_t lw, int _);
+void mad_trk_srad_quant_r   (mflw_t *m, num_t lw, int is);
 
 void mad_trk_solen_thick_t  (mflw_t *m, num_t lw, int _);
 void mad_trk_esept_thick_t  (mflw_t *m, num_t lw, int _);
 void mad_trk_rfcav_kick_t   (mflw_t *m, num_t lw, int _);
 void mad_trk_rfcav_kickn_t  (mflw_t *m, num_t lw, int _);
+void mad_trk_bbeam_kick_t   (mflw_t *m, num_t lw, int _);
+void mad_trk_bbeam_kick6D_t (mflw_t *m, num_t lw, int _);
+void mad_trk_srad_damp_t    (mflw_t *m, num_t lw, int _);
 
 void mad_trk_solen_thick_p  (mflw_t *m, num_t lw, int _);
 void mad_trk_esept_thick_p  (mflw_t *m, num_t lw, int _);
 void mad_trk_rfcav_kick_p   (mflw_t *m, num_t lw, int _);
 void mad_trk_rfcav_kickn_p  (mflw_t *m, num_t lw, int _);
+void mad_trk_bbeam_kick_p   (mflw_t *m, num_t lw, int _);
+void mad_trk_bbeam_kick6D_p (mflw_t *m, num_t lw, int _);
+void mad_trk_srad_damp_p    (mflw_t *m, num_t lw, int _);
+
+// -- curved multipoles (sbend), snm < 0 for automatic order
+const struct cmcoef*
+     mad_trk_curvmul_coef   (ssz_t *n);
+void mad_trk_curvmul_r      (mflw_t *m, int snm, int damo);
+void mad_trk_curvmul_t      (mflw_t *m, int snm, int damo);
 
 // -- do nothing
 void mad_trk_fnil           (mflw_t *m, num_t lw, int _);
@@ -0,0 +1,252 @@
+#ifndef MAD_FTPSA_H
+#define MAD_FTPSA_H
+
+/*
+ o-----------------------------------------------------------------------------o
+ |
+ | Single precision Truncated Power Series Algebra module interface
+ |
+ | Methodical Accelerator Design - Copyright (c) 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o-----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o-----------------------------------------------------------------------------o
+
+  Purpose:
+  - provide a parametric Generalized TPSA package with single precision
+    coefficients (float) for the storage of large maps, generated from the
+    same sources as the double precision and complex GTPSA.
+  - products are accumulated in double precision inside the multiplication
+    kernels and rounded once per coefficient, i.e. the error of c = a*b is
+    bounded by the rounding of the inputs and of c, not by the number of
+    terms of the convolution.
+  - scan, save/load and inversion of maps are not provided, convert to/from
+    double precision GTPSA instead (see flt, dbl), print converts internally.
+
+  Accuracy/speed (relative error in norm vs double precision GTPSA, transfer
+  maps with rotations + random nonlinear terms, nv=4..6, np=0..2, mo=6..12):
+  - mul     : 3e-8 (i.e. 1-2 float ulp, independent of the orders).
+  - compose : 1e-7 to 3e-7 for one composition.
+  - M^k     : 1e-6 to 5e-6 for k=20..100 compositions, i.e. the error grows
+              linearly with the number of operations.
+  - speed is 0.7x to 1.5x the double precision version, i.e. kernels are
+    bound by the index tables, not by the coefficients: the gain is memory.
+  - safe for the storage of maps and for short sequences of operations that
+    need ~1e-6 relative accuracy; not safe for long products, normal forms or
+    map inversions, nor for coefficients outside [1e-38, 3e38] that underflow
+    to zero or overflow (e.g. high orders of unscaled variables).
+
+  Information:
+  - parameters ending with an underscope can be null.
+
+  Errors:
+  - TODO
+
+ o-----------------------------------------------------------------------------o
+ */
+
+#include <stdio.h>
+
+#include "mad_mono.h"
+#include "mad_desc.h"
+#include "mad_tpsa.h"
+
+// --- types -----------------------------------------------------------------o
+
+typedef struct ftpsa_ ftpsa_t;
+
+// --- interface -------------------------------------------------------------o
+
+// ctors, dtor
+ftpsa_t* mad_ftpsa_newd    (const  desc_t *d, ord_t mo); // if mo > d_mo, mo = d_mo
+ftpsa_t* mad_ftpsa_new     (const ftpsa_t *t, ord_t mo);
+void     mad_ftpsa_del     (const ftpsa_t *t);
+
+// introspection
+const
+desc_t*  mad_ftpsa_desc    (const ftpsa_t *t);
+ord_t    mad_ftpsa_mo      (      ftpsa_t *t, ord_t   mo  ); // set mo
+int32_t  mad_ftpsa_uid     (      ftpsa_t *t, int32_t uid_); // set uid if != 0
+str_t    mad_ftpsa_nam     (      ftpsa_t *t, str_t   nam_); // set nam if != null
+ssz_t    mad_ftpsa_len     (const ftpsa_t *t, log_t   hi_ ); // get mo or hi
+ord_t    mad_ftpsa_ord     (const ftpsa_t *t, log_t   hi_ ); // get mo or hi
+log_t    mad_ftpsa_isnul   (const ftpsa_t *t);
+log_t    mad_ftpsa_isval   (const ftpsa_t *t);
+log_t    mad_ftpsa_isvalid (const ftpsa_t *t);
+num_t    mad_ftpsa_density (const ftpsa_t *t, num_t stat_[4], log_t reset); // ratio nz/nc in [0] U [lo,hi] or stat (mu,sig,#prn coefs,#prn ords)
+
+// initialization / manipulation
+void     mad_ftpsa_copy    (const ftpsa_t *t, ftpsa_t *r);
+void     mad_ftpsa_convert (const ftpsa_t *t, ftpsa_t *r, ssz_t n, idx_t t2r_[], int pb);
+idx_t    mad_ftpsa_maxord  (const ftpsa_t *t,             ssz_t n, idx_t idx_[]);
+void     mad_ftpsa_sclord  (const ftpsa_t *t, ftpsa_t *r, log_t inv, log_t prm); // t[i]*o[i]
+void     mad_ftpsa_getord  (const ftpsa_t *t, ftpsa_t *r, ord_t ord);
+void     mad_ftpsa_cutord  (const ftpsa_t *t, ftpsa_t *r, int   ord); // ord..mo = 0 or 0..-ord=0
+void     mad_ftpsa_clrord  (      ftpsa_t *t, ord_t ord);
+void     mad_ftpsa_setvar  (      ftpsa_t *t, flt_t v, idx_t iv, flt_t scl_);
+void     mad_ftpsa_setprm  (      ftpsa_t *t, flt_t v, idx_t ip);
+void     mad_ftpsa_setval  (      ftpsa_t *t, flt_t v);
+void     mad_ftpsa_update  (      ftpsa_t *t);
+void     mad_ftpsa_clear   (      ftpsa_t *t);
+
+// conversion from/to double precision GTPSA (descriptors must be the same)
+void     mad_ftpsa_flt     (const  tpsa_t *t, ftpsa_t *r);
+void     mad_ftpsa_dbl     (const ftpsa_t *t,  tpsa_t *r);
+
+// indexing / monomials (return idx_t = -1 if invalid)
+ord_t    mad_ftpsa_mono    (const ftpsa_t *t, idx_t i, ssz_t n,       ord_t m_[], ord_t *p_);
+idx_t    mad_ftpsa_idxs    (const ftpsa_t *t,          ssz_t n,       str_t s   ); // string mono "[0-9]*"
+idx_t    mad_ftpsa_idxm    (const ftpsa_t *t,          ssz_t n, const ord_t m []);
+idx_t    mad_ftpsa_idxsm   (const ftpsa_t *t,          ssz_t n, const idx_t m []); // sparse mono [(i,o)]
+idx_t    mad_ftpsa_cycle   (const ftpsa_t *t, idx_t i, ssz_t n,       ord_t m_[], flt_t *v_);
+
+// accessors
+flt_t    mad_ftpsa_geti    (const ftpsa_t *t, idx_t i);
+flt_t    mad_ftpsa_gets    (const ftpsa_t *t, ssz_t n,       str_t s  ); // string w orders in '0'-'9'
+flt_t    mad_ftpsa_getm    (const ftpsa_t *t, ssz_t n, const ord_t m[]);
+flt_t    mad_ftpsa_getsm   (const ftpsa_t *t, ssz_t n, const idx_t m[]); // sparse mono [(i,o)]
+void     mad_ftpsa_seti    (      ftpsa_t *t, idx_t i,                  flt_t a, flt_t b); // a*x[i]+b
+void     mad_ftpsa_sets    (      ftpsa_t *t, ssz_t n,       str_t s  , flt_t a, flt_t b); // a*x[m]+b
+void     mad_ftpsa_setm    (      ftpsa_t *t, ssz_t n, const ord_t m[], flt_t a, flt_t b); // a*x[m]+b
+void     mad_ftpsa_setsm   (      ftpsa_t *t, ssz_t n, const idx_t m[], flt_t a, flt_t b); // a*x[m]+b
+void     mad_ftpsa_cpyi    (const ftpsa_t *t, ftpsa_t *r,          idx_t i);
+void     mad_ftpsa_cpys    (const ftpsa_t *t, ftpsa_t *r, ssz_t n, str_t s); // string mono "[0-9]*"
+void     mad_ftpsa_cpym    (const ftpsa_t *t, ftpsa_t *r, ssz_t n, const ord_t m[]);
+void     mad_ftpsa_cpysm   (const ftpsa_t *t, ftpsa_t *r, ssz_t n, const idx_t m[]); // sparse mono [(i,o)]
+
+// accessors vector based
+void     mad_ftpsa_getv    (const ftpsa_t *t, idx_t i, ssz_t n,       flt_t v[]); // return copied length
+void     mad_ftpsa_setv    (      ftpsa_t *t, idx_t i, ssz_t n, const flt_t v[]); // return copied length
+
+// operators
+log_t    mad_ftpsa_equ     (const ftpsa_t *a, const ftpsa_t *b, num_t tol_);
+void     mad_ftpsa_dif     (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c); // (a_i-b_i)/max(|a_i|,1)
+void     mad_ftpsa_add     (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c);
+void     mad_ftpsa_sub     (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c);
+void     mad_ftpsa_mul     (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c);
+void     mad_ftpsa_mulord  (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c, ord_t lo, ord_t hi); // orders [lo,hi] of a*b
+void     mad_ftpsa_div     (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c);
+void     mad_ftpsa_pow     (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c);
+void     mad_ftpsa_powi    (const ftpsa_t *a,       int      n, ftpsa_t *c);
+void     mad_ftpsa_pown    (const ftpsa_t *a,       flt_t    v, ftpsa_t *c);
+
+// functions
+num_t    mad_ftpsa_nrm     (const ftpsa_t *a);
+void     mad_ftpsa_unit    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_abs     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_sqrt    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_exp     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_log     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_sincos  (const ftpsa_t *a, ftpsa_t *s, ftpsa_t *c);
+void     mad_ftpsa_sin     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_cos     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_tan     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_cot     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_sinc    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_sincosh (const ftpsa_t *a, ftpsa_t *s, ftpsa_t *c);
+void     mad_ftpsa_sinh    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_cosh    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_tanh    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_coth    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_sinhc   (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_asin    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_acos    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_atan    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_acot    (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_asinc   (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_asinh   (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_acosh   (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_atanh   (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_acoth   (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_asinhc  (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_erf     (const ftpsa_t *a, ftpsa_t *c);
+void     mad_ftpsa_erfc    (const ftpsa_t *a, ftpsa_t *c);
+
+void     mad_ftpsa_acc     (const ftpsa_t *a, flt_t v, ftpsa_t *c); // c += v*a, aliasing OK
+void     mad_ftpsa_scl     (const ftpsa_t *a, flt_t v, ftpsa_t *c); // c  = v*a
+void     mad_ftpsa_inv     (const ftpsa_t *a, flt_t v, ftpsa_t *c); // c  = v/a
+void     mad_ftpsa_invsqrt (const ftpsa_t *a, flt_t v, ftpsa_t *c); // c  = v/sqrt(a)
+
+void     mad_ftpsa_atan2   (const ftpsa_t *y, const ftpsa_t *x, ftpsa_t *r);
+void     mad_ftpsa_hypot   (const ftpsa_t *x, const ftpsa_t *y, ftpsa_t *r);
+void     mad_ftpsa_hypot3  (const ftpsa_t *x, const ftpsa_t *y, const ftpsa_t *z, ftpsa_t *r);
+
+// functions for differential algebra
+void     mad_ftpsa_integ   (const ftpsa_t *a, ftpsa_t *c, idx_t iv);
+void     mad_ftpsa_deriv   (const ftpsa_t *a, ftpsa_t *c, idx_t iv);
+void     mad_ftpsa_derivm  (const ftpsa_t *a, ftpsa_t *c, ssz_t n, const ord_t m[]);
+void     mad_ftpsa_poisbra (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *c, int nv);
+void     mad_ftpsa_taylor  (const ftpsa_t *a, ssz_t n, const flt_t coef[], ftpsa_t *c);
+void     mad_ftpsa_taylor_h(const ftpsa_t *a, ssz_t n, const flt_t coef[], ftpsa_t *c); // Horner
+
+// batched functions over GTPSAs sharing the same descriptor (parallel over
+// items), aliasing is only allowed between a[i] and c[i]
+void     mad_ftpsa_vinv    (ssz_t n, const ftpsa_t *a[], flt_t v, ftpsa_t *c[]); // c[i] = v/a[i]
+void     mad_ftpsa_vinvsqrt(ssz_t n, const ftpsa_t *a[], flt_t v, ftpsa_t *c[]); // c[i] = v/sqrt(a[i])
+void     mad_ftpsa_vsqrt   (ssz_t n, const ftpsa_t *a[], ftpsa_t *c[]);
+void     mad_ftpsa_vexp    (ssz_t n, const ftpsa_t *a[], ftpsa_t *c[]);
+void     mad_ftpsa_vlog    (ssz_t n, const ftpsa_t *a[], ftpsa_t *c[]);
+void     mad_ftpsa_vsin    (ssz_t n, const ftpsa_t *a[], ftpsa_t *c[]);
+void     mad_ftpsa_vcos    (ssz_t n, const ftpsa_t *a[], ftpsa_t *c[]);
+void     mad_ftpsa_vsincos (ssz_t n, const ftpsa_t *a[], ftpsa_t *s[], ftpsa_t *c[]);
+
+// high level functions
+void     mad_ftpsa_axpb        (flt_t a, const ftpsa_t *x,
+                                flt_t b, ftpsa_t *r);
+void     mad_ftpsa_axpbypc     (flt_t a, const ftpsa_t *x,
+                                flt_t b, const ftpsa_t *y,
+                                flt_t c, ftpsa_t *r);
+void     mad_ftpsa_axypb       (flt_t a, const ftpsa_t *x, const ftpsa_t *y,
+                                flt_t b, ftpsa_t *r);
+void     mad_ftpsa_axypbzpc    (flt_t a, const ftpsa_t *x, const ftpsa_t *y,
+                                flt_t b, const ftpsa_t *z,
+                                flt_t c, ftpsa_t *r);
+void     mad_ftpsa_axypbvwpc   (flt_t a, const ftpsa_t *x, const ftpsa_t *y,
+                                flt_t b, const ftpsa_t *v, const ftpsa_t *w,
+                                flt_t c, ftpsa_t *r);
+void     mad_ftpsa_ax2pby2pcz2 (flt_t a, const ftpsa_t *x,
+                                flt_t b, const ftpsa_t *y,
+                                flt_t c, const ftpsa_t *z, ftpsa_t *r);
+
+void     mad_ftpsa_axpsqrtbpcx2    (const ftpsa_t *x, flt_t a, flt_t b, flt_t c, ftpsa_t *r);
+void     mad_ftpsa_logaxpsqrtbpcx2 (const ftpsa_t *x, flt_t a, flt_t b, flt_t c, ftpsa_t *r);
+void     mad_ftpsa_logxdy          (const ftpsa_t *x, const ftpsa_t *y, ftpsa_t *r);
+
+// map functions (to check for non-homogeneous maps & parameters)
+void     mad_ftpsa_vec2fld  (ssz_t na, const ftpsa_t *a   ,                      ftpsa_t *mc[]); // F . grad
+void     mad_ftpsa_fld2vec  (ssz_t na, const ftpsa_t *ma[],                      ftpsa_t *c   );
+void     mad_ftpsa_fgrad    (ssz_t na, const ftpsa_t *ma[], const ftpsa_t * b  , ftpsa_t *c   );
+void     mad_ftpsa_liebra   (ssz_t na, const ftpsa_t *ma[], const ftpsa_t *mb[], ftpsa_t *mc[]);
+void     mad_ftpsa_exppb    (ssz_t na, const ftpsa_t *ma[], const ftpsa_t *mb[], ftpsa_t *mc[]); // exp(:F:) K
+void     mad_ftpsa_logpb    (ssz_t na, const ftpsa_t *ma[], const ftpsa_t *mb[], ftpsa_t *mc[]); // exp(log(:F:)) K
+
+ord_t    mad_ftpsa_mord     (ssz_t na, const ftpsa_t *ma[], log_t hi); // max mo (or max hi)
+num_t    mad_ftpsa_mnrm     (ssz_t na, const ftpsa_t *ma[]);
+void     mad_ftpsa_compose  (ssz_t na, const ftpsa_t *ma[], ssz_t nb, const ftpsa_t *mb[], ftpsa_t *mc[]);
+void     mad_ftpsa_compose_n(ssz_t na, const ftpsa_t *ma[], ssz_t nb, ssz_t n,             ftpsa_t *mc[]); // ma[n*nb]
+void     mad_ftpsa_translate(ssz_t na, const ftpsa_t *ma[], ssz_t nb, const flt_t    tb[], ftpsa_t *mc[]);
+void     mad_ftpsa_eval     (ssz_t na, const ftpsa_t *ma[], ssz_t nb, const flt_t    tb[], flt_t    tc[]);
+void     mad_ftpsa_mconv    (ssz_t na, const ftpsa_t *ma[], ssz_t nc,                      ftpsa_t *mc[], ssz_t n, idx_t t2r_[], int pb);
+
+// map conversion from/to double precision GTPSA
+void     mad_ftpsa_mflt     (ssz_t na, const  tpsa_t *ma[],                      ftpsa_t *mc[]);
+void     mad_ftpsa_mdbl     (ssz_t na, const ftpsa_t *ma[],                       tpsa_t *mc[]);
+
+// I/O (through double precision GTPSA)
+void     mad_ftpsa_print    (const ftpsa_t *t, str_t name_, num_t eps_, int nohdr_, FILE *stream_);
+
+// unsafe operation (mo vs allocated!!)
+ftpsa_t* mad_ftpsa_init     (      ftpsa_t *t, const desc_t *d, ord_t mo);
+
+// debug
+int      mad_ftpsa_debug    (const ftpsa_t *t, str_t name_, str_t fnam_, int line_, FILE *stream_);
+
+// ---------------------------------------------------------------------------o
+
+#endif // MAD_FTPSA_H
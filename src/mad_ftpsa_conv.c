@@ -0,0 +1,86 @@
+/*
+ o-----------------------------------------------------------------------------o
+ |
+ | FTPSA and TPSA conversion module implementation
+ |
+ | Methodical Accelerator Design - Copyright (c) 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o-----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o-----------------------------------------------------------------------------o
+*/
+
+
+#include "mad_ftpsa_impl.h"
+
+// --- conversion -------------------------------------------------------------o
+
+enum {
+  static_assert__check_hdr_compat = 1/(offsetof(struct  tpsa_, coef) ==
+                                       offsetof(struct ftpsa_, coef))
+};
+
+void
+mad_ftpsa_flt (const tpsa_t *a, ftpsa_t *c)
+{
+  assert(a && c); DBGFUN(->);
+  ensure(IS_COMPAT(a,c), "incompatibles GTPSA (descriptors differ)");
+
+  FUN(copy0)(a, (tpsa_t*)c);
+  c->coef[0] = a->coef[0];
+  TPSA_SCAN(c) c->coef[i] = a->coef[i];
+
+  mad_ftpsa_update(c); // coefs may underflow
+  DBGFUN(<-);
+}
+
+void
+mad_ftpsa_dbl (const ftpsa_t *a, tpsa_t *c)
+{
+  assert(a && c); DBGFUN(->);
+  ensure(IS_COMPAT(a,c), "incompatibles GTPSA (descriptors differ)");
+
+  FUN(copy0)((const tpsa_t*)a, c);
+  c->coef[0] = a->coef[0];
+  TPSA_SCAN(c) c->coef[i] = a->coef[i];
+
+  DBGTPSA(c); DBGFUN(<-);
+}
+
+void
+mad_ftpsa_mflt (ssz_t na, const tpsa_t *ma[na], ftpsa_t *mc[na])
+{
+  assert(ma && mc); DBGFUN(->);
+  FOR(i,na) mad_ftpsa_flt(ma[i], mc[i]);
+  DBGFUN(<-);
+}
+
+void
+mad_ftpsa_mdbl (ssz_t na, const ftpsa_t *ma[na], tpsa_t *mc[na])
+{
+  assert(ma && mc); DBGFUN(->);
+  FOR(i,na) mad_ftpsa_dbl(ma[i], mc[i]);
+  DBGFUN(<-);
+}
+
+// --- I/O --------------------------------------------------------------------o
+
+void
+mad_ftpsa_print (const ftpsa_t *t, str_t name_, num_t eps_, int nohdr_,
+                 FILE *stream_)
+{
+  assert(t); DBGFUN(->);
+  if (!name_ && t->nam[0]) name_ = t->nam;
+  tpsa_t *r = GET_TMPR(t);
+  mad_ftpsa_dbl(t, r);
+  mad_tpsa_print(r, name_, eps_, nohdr_, stream_);
+  REL_TMPR(r); DBGFUN(<-);
+}
+
+// --- end --------------------------------------------------------------------o
@@ -0,0 +1,195 @@
+#ifndef MAD_FTPSA_PRIV_H
+#define MAD_FTPSA_PRIV_H
+
+/*
+ o-----------------------------------------------------------------------------o
+ |
+ | Single precision Truncated Power Series Algebra module implementation (private)
+ |
+ | Methodical Accelerator Design - Copyright (c) 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o-----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o-----------------------------------------------------------------------------o
+*/
+
+#include <assert.h>
+
+#include "mad_bit.h"
+#include "mad_ftpsa.h"
+#include "mad_tpsa_impl.h"
+
+// --- types ------------------------------------------------------------------o
+
+struct ftpsa_ { // warning: opaque type for LuaJIT (see madl_cmad.mad)
+  const desc_t *d;        // ptr to ftpsa descriptor
+  ord_t   lo, hi, mo, ao; // lowest/highest used ord, max ord, allocated ord
+  int32_t uid;            // special user field for external use (and padding)
+  char    nam[NAMSZ];     // tpsa name (max 15 chars)
+  flt_t   coef[]; // warning: must be identical to tpsa up to coef excluded
+};
+
+// --- macros -----------------------------------------------------------------o
+
+#ifdef MAD_FTPSA_IMPL
+
+#define T                ftpsa_t
+#define NUM              flt_t
+#define ACC              num_t  // accumulator of products in kernels
+#define NUMF(name)       MKNAME(mad_num_,name)
+#define FUN(name)        MKNAME(mad_ftpsa_,name)
+#define PFX(name)        MKNAME(f,name)
+#define VAL(num)         (num_t)(num)
+#define VALEPS(num,eps) (fabs(num)<(eps) ? 0 : (num_t)(num))
+#define FMT              "%+6.4lE"
+#define SELECT(R,C)      R
+
+#endif
+
+// --- helpers ----------------------------------------------------------------o
+
+// --- functions accessing lo, hi
+
+static inline void // copy TPSA orders, don't use coef.
+mad_ftpsa_copy0 (const ftpsa_t *t, ftpsa_t *r)
+{
+  assert(t && r);
+  r->lo = t->lo;
+  r->hi = MIN(t->hi, r->mo);
+  if (r->lo > r->hi) r->lo = 1, r->hi = 0;
+}
+
+static inline void // copy TPSA orders, don't use coef.
+mad_ftpsa_copy00 (const ftpsa_t *a, const ftpsa_t *b, ftpsa_t *r)
+{
+  assert(a && b && r);
+  ord_t hi = MAX(a->hi, b->hi);
+  r->lo = MIN(a->lo, b->lo);
+  r->hi = MIN(hi, r->mo);
+  if (r->lo > r->hi) r->lo = 1, r->hi = 0;
+}
+
+static inline void // print TPSA header (for debug)
+mad_ftpsa_print0 (const ftpsa_t *t, str_t nam_)
+{
+  assert(t && t->d);
+  printf("'%s' { lo=%d hi=%d mo=%d ao=%d uid=%d did=%d }\n",
+         nam_?nam_:"?", t->lo, t->hi, t->mo, t->ao, t->uid, t->d->id);
+}
+
+// --- functions accessing lo, hi, coef[0]
+
+static inline ftpsa_t* // reset TPSA
+mad_ftpsa_reset0 (ftpsa_t *t)
+{
+  assert(t);
+  t->lo = 1, t->hi = 0, t->coef[0] = 0;
+  return t;
+}
+
+// --- functions accessing coef[o]
+
+static inline void // clear TPSA order but doesn't adjust lo,hi
+mad_ftpsa_clear0 (ftpsa_t *t, ord_t lo, ord_t hi)
+{
+  assert(t);
+  TPSA_SCAN(t,lo,hi) t->coef[i] = 0;
+}
+
+static inline idx_t // return index of first non-zero coef in [lo,hi] or -1
+mad_ftpsa_nzero0 (const ftpsa_t *t, ord_t lo, ord_t hi, log_t upt)
+{
+  assert(t);
+  if (lo > hi) return -1;
+  const idx_t *o2i = t->d->ord2idx;
+  idx_t i = o2i[lo], ni = o2i[hi+1]-1;
+  flt_t c = t->coef[ni]; ((ftpsa_t*)t)->coef[ni] = 1; // set stopper
+  while (!t->coef[i]) ++i;
+  ((ftpsa_t*)t)->coef[ni] = c;                        // restore value
+  if (i != ni || c) {
+    if (upt) ((ftpsa_t*)t)->lo = t->d->ords[i];
+    return i;
+  } else {
+    if (upt) ((ftpsa_t*)t)->lo = 1, ((ftpsa_t*)t)->hi = 0;
+    return -1;
+  }
+}
+
+static inline idx_t // return index of first non-zero coef in [lo,hi] or -1
+mad_ftpsa_nzero0r (const ftpsa_t *t, ord_t lo, ord_t hi, log_t upt)
+{
+  assert(t);
+  const idx_t *o2i = t->d->ord2idx;
+  for (ord_t o = hi; o >= lo; o--) {
+    idx_t i = o2i[o], ni = o2i[o+1]-1;
+    flt_t c = t->coef[ni]; ((ftpsa_t*)t)->coef[ni] = 1; // set stopper
+    while (!t->coef[i]) ++i;
+    ((ftpsa_t*)t)->coef[ni] = c;                        // restore value
+    if (i != ni || c) {
+      if (upt) ((ftpsa_t*)t)->hi = o;
+      return i;
+    }
+  }
+  if (upt) ((ftpsa_t*)t)->lo = 1, ((ftpsa_t*)t)->hi = 0;
+  return -1;
+}
+
+static inline void // prune coefs below thresholds of each order and adjust lo,hi
+mad_ftpsa_prune0 (ftpsa_t *t)
+{
+  assert(t);
+  const num_t *eps = t->d->prn;
+  if (!eps || t->lo > t->hi) return;    // pruning disabled or scalar
+
+  const idx_t *o2i = t->d->ord2idx;
+  ord_t lo = t->lo, hi = t->hi;
+  long n = 0;
+  for (ord_t o = lo; o <= hi; ++o) {
+    num_t e = eps[o];
+    if (e > 0)
+      for (idx_t i = o2i[o]; i < o2i[o+1]; ++i)
+        if (t->coef[i] && fabs(t->coef[i]) < e) t->coef[i] = 0, ++n;
+  }
+  if (!n) return;
+
+  if (mad_ftpsa_nzero0(t,lo,hi,1) >= 0) mad_ftpsa_nzero0r(t,t->lo,hi,1);
+
+  desc_t *d = (desc_t*)t->d;
+  num_t no = (hi-lo+1) - (t->lo <= t->hi ? t->hi-t->lo+1 : 0); // dropped orders
+  #pragma omp atomic
+  d->prn_n += n;
+  #pragma omp atomic
+  d->prn_o += no;
+}
+
+// --- temporaries ------------------------------------------------------------o
+
+#if DESC_USE_TMP
+
+// descriptors have no pool of ftpsa temporaries, use the heap instead
+
+static inline ftpsa_t*
+mad_ftpsa_gettmp (const ftpsa_t *t, const str_t func)
+{
+  assert(t); (void)func;
+  return mad_ftpsa_new(t, mad_tpsa_same);
+}
+
+static inline void
+mad_ftpsa_reltmp (ftpsa_t *tmp, const str_t func)
+{
+  assert(tmp); (void)func;
+  mad_ftpsa_del(tmp);
+}
+
+#endif // DESC_USE_TMP
+
+// --- end --------------------------------------------------------------------o
+
+#endif // MAD_FTPSA_PRIV_H
@@ -28,6 +28,7 @@
 #include "mad_mem.h"
 #include "mad_vec.h"
 #include "mad_mat.h"
+#include "mad_cst.h"
 
 #define MAD_USE_MADX 0
 
@@ -163,7 +164,7 @@ void mad_imat_reshape (struct imatrix *x, ssz_t m, ssz_t n)
 // [m x n] = [m x p] * [p x n]
 #define MUL() \
   switch(((m == 1) << 1) & (n == 1)) { \
-    case 0: MMUL(); break; \
+    case 0: if (BLK(MMUL_BLK)) { BMMUL(); } else { MMUL(); } break; \
     case 1: MULV(); break; \
     case 2: VMUL(); break; \
     case 3: IMUL(); break; \
@@ -251,7 +252,7 @@ void mad_imat_reshape (struct imatrix *x, ssz_t m, ssz_t n)
 // [m x n] = [p x m]' * [p x n]
 #define TMUL(C) \
   switch(((m == 1) << 1) & (n == 1)) { \
-    case 0: TMMUL(C); break; \
+    case 0: if (BLK(TMMUL_BLK)) { BTMMUL(C); } else { TMMUL(C); } break; \
     case 1: TMULV(C); break; \
     case 2: TVMUL(C); break; \
     case 3: TIMUL(C); break; \
@@ -324,7 +325,7 @@ void mad_imat_reshape (struct imatrix *x, ssz_t m, ssz_t n)
 // [m x n] = [m x p] * [n x p]'
 #define MULT(C) \
   switch(((m == 1) << 1) & (n == 1)) { \
-    case 0: MMULT(C); break; \
+    case 0: if (BLK(MMULT_BLK)) { BMMULT(C); } else { MMULT(C); } break; \
     case 1: MULVT(C); break; \
     case 2: VMULT(C); break; \
     case 3: IMULT(C); break; \
@@ -332,6 +333,65 @@ void mad_imat_reshape (struct imatrix *x, ssz_t m, ssz_t n)
 
 // -----
 
+// large matrices, cache-blocked and multithreaded loops, rows of r are shared
+// between threads (i.e. no race). Thresholds in flops (m*n*p) are heuristic
+// defaults per op (i.e. not tuned per machine), plain loops are used below.
+
+#define MMUL_BLK  (1 << 24)
+#define TMMUL_BLK (1 << 24)
+#define MMULT_BLK (1 << 21)
+
+#define BLK(T) ((size_t)m*n*p >= (T))
+
+#define BLK_M  64
+#define BLK_N 256
+#define BLK_P 256
+
+#define BLKLOOP(BODY) \
+  _Pragma("omp parallel for schedule(static)") \
+  FOR(ii,0,m,BLK_M) { \
+    const idx_t im = MIN(ii+BLK_M, m); \
+    FOR(i,ii,im) FOR(j,n) r[i*n+j] = 0; \
+    FOR(jj,0,n,BLK_N) { const idx_t jm = MIN(jj+BLK_N, n); \
+    FOR(kk,0,p,BLK_P) { const idx_t km = MIN(kk+BLK_P, p); BODY; } } \
+  }
+
+// [m x n] = [m x p] * [p x n]
+#define BMMUL() /* mat * mat */ \
+  BLKLOOP(FOR(i,ii,im) FOR(k,kk,km) FOR(j,jj,jm) \
+          r[i*n+j] += x[i*p+k] * y[k*n+j])
+
+// [m x n] = [p x m]' * [p x n]
+#define BTMMUL(C) /* mat' * mat */ \
+  BLKLOOP(FOR(k,kk,km) FOR(i,ii,im) FOR(j,jj,jm) \
+          r[i*n+j] += C(x[k*m+i]) * y[k*n+j])
+
+// [m x n] = [m x p] * [n x p]'
+#define BMMULT(C) /* mat * mat' */ \
+  BLKLOOP(FOR(i,ii,im) FOR(j,jj,jm) FOR(k,kk,km) \
+          r[i*n+j] += x[i*p+k] * C(y[j*p+k]))
+
+// large real matrices, optional dispatch to BLAS (build with -DMAD_USE_BLAS=1
+// and link an optimized BLAS, the reference BLAS is slower than the above).
+
+#ifndef MAD_USE_BLAS
+#define MAD_USE_BLAS 0
+#endif
+
+void dgemm_ (str_t transa, str_t transb, const int *m, const int *n, const int *k,
+             const num_t *alpha, const num_t A[], const int *lda,
+                                 const num_t B[], const int *ldb,
+             const num_t *beta ,       num_t C[], const int *ldc);
+
+// row-major r = op(x) * op(y) <=> col-major r' = op(y)' * op(x)'
+#define GEMM(TY,TX,LDY,LDX) { \
+  const int nm=m, nn=n, np=p, ly=LDY, lx=LDX; \
+  const num_t one=1, zero=0; \
+  dgemm_(TY, TX, &nn, &nm, &np, &one, y, &ly, x, &lx, &zero, r, &nn); \
+}
+
+// -----
+
 // r[m x n] = diag(x[m x p]) * y[p x n]
 // naive implementation (more efficient on recent superscalar arch!)
 #define DMUL() /* diag(mat) * mat */ \
@@ -388,6 +448,107 @@ void mad_imat_reshape (struct imatrix *x, ssz_t m, ssz_t n)
 // [m x n] diagonal [+ op]
 #define DIAG(OP) FOR(i, MIN(m,n)) r[i*ldr+i] OP##= x
 
+// -----
+
+// small square matrices [N x N] with N = 2, 4, 6 (i.e. physics hot paths)
+// sizes are known at compile time, loops are unrolled and vectorized by the
+// compiler, no temporary allocation and no LAPACK call (alias r == x allowed).
+
+#define SMALL(n) ((n) == 6 || (n) == 4 || (n) == 2)
+
+#define SMUL(N) \
+static inline void \
+smul##N (const num_t x[N*N], const num_t y[N*N], num_t r[N*N]) \
+{ \
+  num_t t[N*N] = {0}; \
+  for (int i=0; i < N; i++) \
+  for (int k=0; k < N; k++) \
+  for (int j=0; j < N; j++) t[i*N+j] += x[i*N+k] * y[k*N+j]; \
+  memcpy(r, t, sizeof t); \
+}
+
+// LU with partial pivoting, return 0 or k+1 if pivot k is zero (as dgetrf)
+#define SDET(N) \
+static inline int \
+sdet##N (const num_t x[N*N], num_t *r) \
+{ \
+  num_t a[N*N], t, det = 1; \
+  memcpy(a, x, sizeof a); \
+  for (int k=0; k < N; k++) { \
+    int p = k; \
+    for (int i=k+1; i < N; i++) if (fabs(a[i*N+k]) > fabs(a[p*N+k])) p = i; \
+    if (a[p*N+k] == 0) return *r = 0, k+1; \
+    if (p != k) { \
+      for (int j=k; j < N; j++) SWAP(a[k*N+j], a[p*N+j], t); \
+      det = -det; \
+    } \
+    det *= a[k*N+k]; \
+    for (int i=k+1; i < N; i++) { \
+      const num_t f = a[i*N+k] / a[k*N+k]; \
+      for (int j=k+1; j < N; j++) a[i*N+j] -= f*a[k*N+j]; \
+    } \
+  } \
+  return *r = det, 0; \
+}
+
+// Gauss-Jordan with partial pivoting, return 0 if the ratio of the smallest to
+// the largest pivot (estimate of 1/cond) is not above rcond, e.g. zero pivot
+#define SINV(N) \
+static inline int \
+sinv##N (const num_t x[N*N], num_t r[N*N], num_t rcond) \
+{ \
+  num_t a[N*N], b[N*N] = {0}, t, pmin = 0, pmax = 0; \
+  memcpy(a, x, sizeof a); \
+  for (int k=0; k < N; k++) b[k*N+k] = 1; \
+  for (int k=0; k < N; k++) { \
+    int p = k; \
+    for (int i=k+1; i < N; i++) if (fabs(a[i*N+k]) > fabs(a[p*N+k])) p = i; \
+    const num_t piv = fabs(a[p*N+k]); \
+    if (piv == 0) return 0; \
+    pmin = k ? MIN(pmin, piv) : piv, pmax = MAX(pmax, piv); \
+    if (p != k) for (int j=0; j < N; j++) \
+      SWAP(a[k*N+j], a[p*N+j], t), SWAP(b[k*N+j], b[p*N+j], t); \
+    const num_t f = 1/a[k*N+k]; \
+    for (int j=0; j < N; j++) a[k*N+j] *= f, b[k*N+j] *= f; \
+    for (int i=0; i < N; i++) if (i != k) { \
+      const num_t g = a[i*N+k]; \
+      for (int j=0; j < N; j++) a[i*N+j] -= g*a[k*N+j], b[i*N+j] -= g*b[k*N+j]; \
+    } \
+  } \
+  if (pmin <= rcond*pmax) return 0; \
+  memcpy(r, b, sizeof b); \
+  return 1; \
+}
+
+SMUL(2) SMUL(4) SMUL(6)
+        SDET(4) SDET(6)
+        SINV(4) SINV(6)
+
+static inline int
+sdet2 (const num_t x[4], num_t *r)
+{
+  *r = x[0]*x[3] - x[1]*x[2];
+  return *r == 0 ? 2 : 0;
+}
+
+static inline int
+sinv2 (const num_t x[4], num_t r[4], num_t rcond)
+{
+  const num_t det = x[0]*x[3] - x[1]*x[2];
+  const num_t piv = MAX(fabs(x[0]), fabs(x[2])); // pivots are piv, det/piv
+  if (det == 0 || fabs(det) <= rcond*piv*piv) return 0;
+  const num_t a = x[0], f = 1/det;
+  r[0] = x[3]*f, r[1] = -x[1]*f, r[2] = -x[2]*f, r[3] = a*f;
+  return 1;
+}
+
+#define SDISPATCH(FUN,N,...) \
+  ((N) == 6 ? FUN##6(__VA_ARGS__) : (N) == 4 ? FUN##4(__VA_ARGS__) : FUN##2(__VA_ARGS__))
+
+#undef SMUL
+#undef SDET
+#undef SINV
+
 // --- mat
 
 void mad_mat_eye (num_t r[], num_t v, ssz_t m, ssz_t n, ssz_t ldr)
@@ -404,6 +565,10 @@ void mad_mat_trans (const num_t x[], num_t r[], ssz_t m, ssz_t n)
 
 void mad_mat_mul (const num_t x[], const num_t y[], num_t r[], ssz_t m, ssz_t n, ssz_t p)
 { CHKXYR;
+  if (m == n && n == p && SMALL(n)) { SDISPATCH(smul, n, x, y, r); return; }
+#if MAD_USE_BLAS
+  if (x != r && y != r && BLK(MMUL_BLK)) { GEMM("N","N",n,p); return; }
+#endif
   if (x != r && y != r) { MUL(); return; }
   mad_alloc_tmp(num_t, r_, m*n);
   num_t *t = r; r = r_;
@@ -424,6 +589,9 @@ void mad_mat_mulm (const num_t x[], const cpx_t y[], cpx_t r[], ssz_t m, ssz_t n
 
 void mad_mat_tmul (const num_t x[], const num_t y[], num_t r[], ssz_t m, ssz_t n, ssz_t p)
 { CHKXYR;
+#if MAD_USE_BLAS
+  if (x != r && y != r && BLK(TMMUL_BLK)) { GEMM("N","T",n,m); return; }
+#endif
   if (x != r && y != r) { TMUL(); return; }
   mad_alloc_tmp(num_t, r_, m*n);
   num_t *t = r; r = r_;
@@ -444,6 +612,9 @@ void mad_mat_tmulm (const num_t x[], const cpx_t y[], cpx_t r[], ssz_t m, ssz_t
 
 void mad_mat_mult (const num_t x[], const num_t y[], num_t r[], ssz_t m, ssz_t n, ssz_t p)
 { CHKXYR;
+#if MAD_USE_BLAS
+  if (x != r && y != r && BLK(MMULT_BLK)) { GEMM("T","N",p,p); return; }
+#endif
   if (x != r && y != r) { MULT(); return; }
   mad_alloc_tmp(num_t, r_, m*n);
   num_t *t = r; r = r_;
@@ -1033,6 +1204,8 @@ int
 mad_mat_det (const num_t x[], num_t *r, ssz_t n)
 {
   CHKX;
+  if (SMALL(n)) return SDISPATCH(sdet, n, x, r);
+
   const int nn=n;
   int info=0, ipiv[n];
   mad_alloc_tmp(num_t, a, n*n);
@@ -1076,7 +1249,12 @@ mad_cmat_det (const cpx_t x[], cpx_t *r, ssz_t n)
 int
 mad_mat_invn (const num_t y[], num_t x, num_t r[], ssz_t m, ssz_t n, num_t rcond)
 {
-  CHKYR; // compute U:[n x n]/Y:[m x n]
+  CHKYR; // compute U:[n x n]/Y:[m x n], ill-conditioned small ones by div
+  if (m == n && SMALL(n) && SDISPATCH(sinv, n, y, r, rcond)) {
+    if (x != 1) mad_vec_muln(r, x, r, m*n);
+    return n;
+  }
+
   mad_alloc_tmp(num_t, u, n*n);
   mad_mat_eye(u, 1, n, n, n);
 #pragma GCC diagnostic push // remove false-positive
@@ -1273,6 +1451,7 @@ mad_mat_div (const num_t x[], const num_t y[], num_t r[], ssz_t m, ssz_t n, ssz_
     dgesv_(&np, &nm, a, &np, ipiv, r, &np, &info);
     if (!info) return mad_free_tmp(a), n;
     if (info > 0) warn("Div: singular matrix, no solution found");
+    mad_vec_copy(y, a, n*p); // overwritten by LU factors
   }
 
   // non-square system or singular square system, use QR or LQ factorization
@@ -1310,6 +1489,7 @@ mad_mat_divm (const num_t x[], const cpx_t y[], cpx_t r[], ssz_t m, ssz_t n, ssz
     zgesv_(&np, &nm, a, &np, ipiv, r, &np, &info);
     if (!info) return mad_free_tmp(a), n;
     if (info > 0) warn("Div: singular matrix, no solution found");
+    mad_cvec_copy(y, a, n*p); // overwritten by LU factors
   }
 
   // non-square system or singular square system, use QR or LQ factorization
@@ -1348,6 +1528,7 @@ mad_cmat_div (const cpx_t x[], const cpx_t y[], cpx_t r[], ssz_t m, ssz_t n, ssz
     zgesv_(&np, &nm, a, &np, ipiv, r, &np, &info);
     if (!info) return mad_free_tmp(a), n;
     if (info > 0) warn("Div: singular matrix, no solution found");
+    mad_cvec_copy(y, a, n*p); // overwritten by LU factors
   }
 
   // non-square system or singular square system, use QR or LQ factorization
@@ -1386,6 +1567,7 @@ mad_cmat_divm (const cpx_t x[], const num_t y[], cpx_t r[], ssz_t m, ssz_t n, ss
     zgesv_(&np, &nm, a, &np, ipiv, r, &np, &info);
     if (!info) return mad_free_tmp(a), n;
     if (info > 0) warn("Div: singular matrix, no solution found");
+    mad_vec_copyv(y, a, n*p); // overwritten by LU factors
   }
 
   // non-square system or singular square system, use QR or LQ factorization
@@ -2715,6 +2897,319 @@ mad_mat_nsolve(const num_t a[], const num_t b[], num_t x[], ssz_t m, ssz_t n,
   return N;
 }
 
+// -- Orbit Response Matrix ---------------------------------------------------o
+
+void // Response matrix of correctors kicks at monitors from optical functions
+mad_mat_orm (num_t a[], const num_t bm[], const num_t mm[], const num_t bc[],
+             const num_t mc[], const idx_t jc_[], ssz_t m, ssz_t n, ssz_t lda,
+             num_t nu, log_t ring)
+{
+  assert(a && bm && mm && bc && mc);
+
+  // Notes: a[m x lda] is a block of rows of the full response matrix, column
+  // of corrector j is jc[j] (e.g. shared correctors) or j, phases are in [2pi]
+  // and beta functions must be positive.
+
+  const num_t pnu = mad_cst_PI*nu;
+  const num_t cnu = ring ? 1/(2*sin(pnu)) : 0;
+
+  mad_alloc_tmp(num_t, sbm, m);
+  FOR(i,m) sbm[i] = sqrt(bm[i]);
+
+  #pragma omp parallel for if (m*n > 100000)
+  FOR(j,n) {
+    const idx_t  k  = jc_ ? jc_[j] : j;
+    const num_t sbc = sqrt(bc[j]);
+    if (ring)
+      FOR(i,m) a[i*lda+k] = sbm[i]*sbc * cos(mad_cst_2PI*fabs(mm[i]-mc[j]) - pnu) * cnu;
+    else
+      FOR(i,m) a[i*lda+k] = mm[i] > mc[j] ? sbm[i]*sbc * sin(mad_cst_2PI*(mm[i]-mc[j])) : 0;
+  }
+
+  mad_free_tmp(sbm);
+}
+
+// -- Cached Least Squares (R factor of A = QR) -------------------------------o
+
+/*
+  The R factor of A = QR satisfies R'R = A'A and is enough to solve repeatedly
+  min || b - Ax ||_2 by the corrected semi-normal equations R'R x = A'b (one
+  step of iterative refinement), without storing Q [m x m]. Disabling a column
+  (corrector) or a row (monitor) of A is a rank-1 update of R in O(n^2) instead
+  of a new factorization in O(mn^2).
+
+  Reference:
+  A. Bjorck, "Numerical Methods for Least Squares Problems", SIAM, 1996.
+  J.J. Dongarra et al., "LINPACK Users' Guide", SIAM, 1979 (dchdd).
+*/
+
+void dgeqrf_ (const int *m, const int *n, num_t A[], const int *lda,
+              num_t tau[], num_t work[], const int *lwork, int *info);
+
+#define R(i,j) r[(i)*n+(j)]
+
+int // R[n x n] from A[m x n] = QR with m >= n
+mad_mat_rqr (const num_t a[], num_t r[], ssz_t m, ssz_t n)
+{
+  assert(a && r);
+  ensure(m >= n, "RQR: invalid sizes (m >= n expected)");
+  int info=0;
+  const int nm=m, nn=n;
+
+  num_t sz;
+  int lwork=-1;
+  mad_alloc_tmp(num_t, ta, m*n);
+  mad_alloc_tmp(num_t, tau, n);
+  mad_mat_trans(a, ta, m, n);
+  dgeqrf_(&nm, &nn, ta, &nm, tau, &sz, &lwork, &info); // query
+  lwork=sz;
+  mad_alloc_tmp(num_t, wk, lwork);
+  dgeqrf_(&nm, &nn, ta, &nm, tau,  wk, &lwork, &info); // compute
+
+  // R is stored in the upper triangle of column-major ta
+  FOR(i,n) {
+    FOR(j,i  ) R(i,j) = 0;
+    FOR(j,i,n) R(i,j) = ta[j*m+i];
+  }
+
+  mad_free_tmp(wk); mad_free_tmp(tau); mad_free_tmp(ta);
+
+  if (info < 0) error("RQR: invalid input argument");
+
+  return info;
+}
+
+void // remove column k of A, R[n x n] -> R[n-1 x n-1] (packed)
+mad_mat_rqr_remcol (num_t r[], idx_t k, ssz_t n)
+{
+  assert(r && 0 <= k && k < n);
+
+  // shift columns k+1.. to the left, R becomes upper Hessenberg from row k
+  FOR(i,n) FOR(j,k,n-1) R(i,j) = R(i,j+1);
+
+  // restore triangular form with Givens rotations on rows (i,i+1)
+  FOR(i,k,n-1) {
+    num_t x = R(i,i), y = R(i+1,i), h = hypot(x,y);
+    if (h == 0) continue;
+    num_t c = x/h, s = y/h;
+    FOR(j,i,n-1) {
+      num_t u = R(i,j), v = R(i+1,j);
+      R(i  ,j) = c*u + s*v;
+      R(i+1,j) = c*v - s*u;
+    }
+  }
+
+  // pack rows with stride n-1
+  FOR(i,n-1) FOR(j,n-1) r[i*(n-1)+j] = R(i,j);
+}
+
+int // remove row v[n] of A, i.e. R'R - vv' (Cholesky downdate)
+mad_mat_rqr_remrow (num_t r[], const num_t v[], ssz_t n)
+{
+  assert(r && v);
+  mad_alloc_tmp(num_t, p, n);
+  mad_alloc_tmp(num_t, c, n);
+  mad_alloc_tmp(num_t, s, n);
+
+  // solve R'p = v
+  num_t nrm = 0;
+  FOR(i,n) {
+    num_t t = v[i];
+    FOR(k,i) t -= R(k,i)*p[k];
+    p[i] = R(i,i) != 0 ? t/R(i,i) : 0;
+    nrm += p[i]*p[i];
+  }
+
+  int info = 0;
+  if (nrm >= 1) { info = -1; goto finalize; } // R'R - vv' not positive definite
+
+  // rotations that zero p from bottom to top
+  num_t alpha = sqrt(1-nrm);
+  RFOR(i,n) {
+    num_t scl = alpha + fabs(p[i]);
+    num_t a = alpha/scl, b = p[i]/scl, h = sqrt(a*a+b*b);
+    c[i] = a/h, s[i] = b/h, alpha = scl*h;
+  }
+
+  // apply rotations to columns of R
+  FOR(j,n) {
+    num_t xx = 0;
+    RFOR(i,j+1) {
+      num_t t  = c[i]*xx + s[i]*R(i,j);
+      R(i,j) = c[i]*R(i,j) - s[i]*xx;
+      xx = t;
+    }
+  }
+
+finalize:
+  mad_free_tmp(p);
+  mad_free_tmp(c);
+  mad_free_tmp(s);
+  return info;
+}
+
+static inline void // solve R'R x = x in place, null pivots give null components
+rqr_solve (const num_t r[], num_t x[], ssz_t n, num_t tol)
+{
+  FOR(i,n) {
+    num_t t = x[i];
+    FOR(k,i) t -= R(k,i)*x[k];
+    x[i] = fabs(R(i,i)) > tol ? t/R(i,i) : 0;
+  }
+  RFOR(i,n) {
+    num_t t = x[i];
+    FOR(k,i+1,n) t -= R(i,k)*x[k];
+    x[i] = fabs(R(i,i)) > tol ? t/R(i,i) : 0;
+  }
+}
+
+int // min || b - Ax ||_2 using R of A = QR (corrected semi-normal equations)
+mad_mat_rqr_solve (const num_t a[], const num_t r[], const num_t b[], num_t x[],
+                   ssz_t m, ssz_t n, num_t rcond)
+{
+  assert(a && r && b && x);
+
+  // rank and tolerance on pivots
+  num_t rmax = 0;
+  FOR(i,n) rmax = MAX(rmax, fabs(R(i,i)));
+  num_t tol = MAX(fabs(rcond), DBL_EPSILON) * rmax;
+  int rank = 0;
+  FOR(i,n) rank += fabs(R(i,i)) > tol;
+
+  mad_alloc_tmp(num_t, res, m);
+  mad_alloc_tmp(num_t, dx , n);
+
+  // x = (R'R)^-1 A'b
+  mad_mat_tmul(a, b, x, n, 1, m);
+  rqr_solve(r, x, n, tol);
+
+  // one step of refinement: dx = (R'R)^-1 A'(b - Ax)
+  mad_mat_mul(a, x, res, m, 1, n);
+  mad_vec_sub(b, res, res, m);
+  mad_mat_tmul(a, res, dx, n, 1, m);
+  rqr_solve(r, dx, n, tol);
+  mad_vec_add(x, dx, x, n);
+
+  mad_free_tmp(res);
+  mad_free_tmp(dx);
+  return rank;
+}
+
+#undef R
+
+// -- Closed Orbit (batched Newton) -------------------------------------------o
+
+// Solve a x = b for small dense a (d x d) using Gaussian elimination with
+//   complete pivoting, a and b are destroyed, x = b on output.
+// Return:  rank of a w.r.t. rcond (i.e. |pivot| > rcond*|first pivot|), the
+//          components of the null space are set to zero (basic solution).
+
+static int
+smsolve (num_t a[], num_t b[], int d, num_t rcond)
+{
+  int  pc[d], r = 0;
+  num_t p0 = 0;
+
+  FOR(k,d) pc[k] = k;
+
+  for (; r < d; r++) {
+    // find pivot
+    int ip = r, jp = r;
+    num_t p = 0;
+    FOR(i,r,d) FOR(j,r,d)
+      if (fabs(a[i*d+j]) > p) p = fabs(a[i*d+j]), ip = i, jp = j;
+
+    if (!r) p0 = p;
+    if (p <= rcond*p0 || p == 0) break;
+
+    // swap rows and columns
+    num_t t;
+    int   u;
+    if (ip != r) { FOR(j,d) SWAP(a[r*d+j], a[ip*d+j], t); SWAP(b[r], b[ip], t); }
+    if (jp != r) { FOR(i,d) SWAP(a[i*d+r], a[i*d+jp], t); SWAP(pc[r], pc[jp], u); }
+
+    // eliminate
+    FOR(i,r+1,d) {
+      const num_t f = a[i*d+r] / a[r*d+r];
+      FOR(j,r+1,d) a[i*d+j] -= f*a[r*d+j];
+      b[i] -= f*b[r];
+    }
+  }
+
+  // back substitution (basic solution)
+  num_t x[d];
+  FOR(k,r,d) x[k] = 0;
+  RFOR(i,r) {
+    num_t s = b[i];
+    FOR(j,i+1,r) s -= a[i*d+j]*x[j];
+    x[i] = s / a[i*d+i];
+  }
+  FOR(k,d) b[pc[k]] = x[k];
+
+  return r;
+}
+
+// Batched Newton step for the closed orbits search using finite differences.
+// Input:   y   = n blocks of 7 tracked particles (orbit + 6 shifted), n x 7 x 6,
+//          ic  = index of the orbit of each block in x0 and dh,
+//          x0  = initial orbits (nx6), updated if not converged,
+//          dh  = finite differences steps,
+//          o1  = final translation (6),
+//          tp  = totalpath (i.e. 4D only), tol = closed orbit tolerance,
+//          dptol = tolerance to detect 6D jacobian (see has_dpt).
+// Output:  dx  = orbits corrections (n x 6), st = status of each block:
+//          0 = continue, 1 = stable, 2 = singular, rk = rank of each block,
+//          r_  = optional jacobians (n x 6 x 6).
+// Return:  number of blocks to continue.
+// Note:    dx solves (R-I)dx = (X-O1)-X0 for R_jk = dX_j/dX0_k (see cofind).
+
+ssz_t
+mad_mat_conewton (const num_t y[], const idx_t ic[], num_t x0[], const num_t dh[],
+                  const num_t o1[6], num_t dx[], idx_t st[], idx_t rk[], num_t r_[],
+                  ssz_t n, log_t tp, num_t tol, num_t dptol)
+{
+  assert(y && ic && x0 && dh && o1 && dx && st && rk);
+  ssz_t nc = 0;
+
+  #pragma omp parallel for reduction(+:nc) if (n >= 64)
+  FOR(b,n) {
+    const num_t *yb = y+b*42, h = dh[ic[b]];
+          num_t *xb = x0+ic[b]*6, *db = dx+b*6;
+    num_t r[36], a[36];
+
+    // jacobian R_jk = df(x_j)/dx_k
+    FOR(j,6) FOR(k,6) r[j*6+k] = (yb[(k+1)*6+j] - yb[j]) / h;
+    if (r_) mad_vec_copy(r, r_+b*36, 36);
+
+    // 6D if not totalpath and dependency on pt (see has_dpt)
+    int i = 0;
+    if (fabs(r[35]-1) <= dptol) while (i < 5 && fabs(r[30+i]) <= dptol) ++i;
+    const int d = !tp && i != 5 ? 6 : 4;
+
+    // dx = (X-O1) - X0
+    num_t dmax = 0;
+    FOR(k,6) db[k] = k < d ? yb[k]-o1[k]-xb[k] : 0, dmax = MAX(dmax, fabs(db[k]));
+
+    int rnk = d;
+    if (dmax > tol) {
+      FOR(j,d) FOR(k,d) a[j*d+k] = r[j*6+k] - (j == k);
+      rnk = smsolve(a, db, d, DBL_EPSILON);
+      dmax = 0;
+      FOR(k,d) db[k] = -db[k], dmax = MAX(dmax, fabs(db[k]));
+    }
+
+    rk[b] = rnk;
+    if (rnk < d)        st[b] = 2; // singular
+    else if (dmax <= tol) st[b] = 1; // stable
+    else {
+      FOR(k,d) xb[k] += db[k];     // adjust orbit
+      st[b] = 0, nc += 1;
+    }
+  }
+
+  return nc;
+}
+
 // -- Survey Misalignments ----------------------------------------------------o
 
 #define N 3
@@ -2723,8 +3218,6 @@ mad_mat_nsolve(const num_t a[], const num_t b[], num_t x[], ssz_t m, ssz_t n,
 // Tbar = W^t (RV+T-V)
 // Rbar = W^t R W
 
-#include "mad_cst.h"
-
 void
 mad_mat_rtbar (num_t Rb[NN],       num_t Tb[N], num_t el, num_t ang, num_t tlt,
          const num_t R_[NN], const num_t T [N])
@@ -2773,3 +3266,121 @@ mad_mat_rtbar (num_t Rb[NN],       num_t Tb[N], num_t el, num_t ang, num_t tlt,
 }
 
 #undef N
+
+// -- Survey (batched) --------------------------------------------------------o
+
+#define N 3
+
+// Each element acts on the global frame through an affine transform (R,T) as
+// V = V+W*T and W = W*R, hence transforms compose as (R1,T1).(R2,T2) = (R1*R2,
+// T1+R1*T2) and the frames at the exit of the elements are the prefixes of
+// this associative product, computed by chunks in parallel (three passes).
+// Packed geometry of element i (see madl_survey.mad):
+//   g[10*i+0..6] = tx, ty, tz, ax, ay, az, inv: patch T then rotzxy(ax,ay,az,inv),
+//   g[10*i+7..9] = el, ang, tlt               : body (straight or curved, tilted).
+// Rows 0 of V[3(n+1)], W[9(n+1)], A[3(n+1)] hold the initial frame and angles
+// (theta, phi, psi), rows 1..n receive the frames and angles at exit.
+
+enum { SRV_NG = 10 };
+
+static inline void
+srv_cmp (const num_t R1[NN], const num_t T1[N], num_t R2[NN], num_t T2[N])
+{ // (R2,T2) = (R1,T1).(R2,T2)
+  num_t r[NN], t[N];
+  FOR(i,N) { t[i] = T1[i]; FOR(k,N) t[i] += R1[i*N+k]*T2[k]; }
+  FOR(i,N) FOR(j,N) {
+    r[i*N+j] = 0;
+    FOR(k,N) r[i*N+j] += R1[i*N+k]*R2[k*N+j];
+  }
+  MCPY(r,R2);
+  VCPY(t,T2);
+}
+
+static inline void
+srv_elm (const num_t g[SRV_NG], num_t R[NN], num_t T[N])
+{
+  const num_t el = g[7], ang = g[8], tlt = g[9];
+
+  // patch
+  T[0] = g[0], T[1] = g[1], T[2] = g[2];
+  if (g[3] || g[4] || g[5]) mad_mat_rotyxz(R, -g[3], -g[4], -g[5], !g[6]);
+  else mad_mat_eye(R, 1, N, N, N);
+
+  // body
+  if (fabs(ang) < mad_cst_MINANG) {
+    if (el) FOR(i,N) T[i] += R[i*N+2]*el;
+    return;
+  }
+
+  num_t rho = el/ang, ca = cos(ang), sa = sin(ang);
+  num_t Ve[N] = {rho*(ca-1), 0, rho*sa};
+  num_t We[NN]; mad_mat_roty(We, -ang);
+
+  if (tlt) { // We = Rz*We*Rz:t(), Ve = Rz*Ve
+    num_t Rz[NN], Wt[NN];
+    mad_mat_rotz(Rz, tlt);
+    mad_mat_mul (Rz, Ve, Ve, N, 1, N);
+    mad_mat_mul (Rz, We, Wt, N, N, N);
+    mad_mat_mult(Wt, Rz, We, N, N, N);
+  }
+  srv_cmp(R, T, We, Ve);
+  MCPY(We,R);
+  VCPY(Ve,T);
+}
+
+void
+mad_mat_survey (const num_t g[], ssz_t n, num_t V[], num_t W[], num_t A[])
+{
+  assert(g && V && W && A);
+  if (n <= 0) return;
+
+  const int nt = n >= 4096 ? omp_get_max_threads() : 1;
+  num_t  *R = W+NN, *T = V+N; // local prefixes in place
+  idx_t bnd[nt+1];
+  num_t cR[nt+1][NN], cT[nt+1][N];
+
+  FOR(k,nt+1) bnd[k] = (idx_t)((int64_t)n*k/nt);
+
+  // local prefixes of chunks
+  #pragma omp parallel for if (nt > 1)
+  FOR(k,nt) {
+    num_t r[NN], t[N];
+    mad_mat_eye(r, 1, N, N, N); t[0] = t[1] = t[2] = 0;
+    FOR(i,bnd[k],bnd[k+1]) {
+      num_t Re[NN], Te[N];
+      srv_elm(g+SRV_NG*i, Re, Te);
+      srv_cmp(r, t, Re, Te);
+      num_t *Ri = R+NN*i, *Ti = T+N*i;
+      MCPY(Re,r);
+      VCPY(Te,t);
+      MCPY(r,Ri);
+      VCPY(t,Ti);
+    }
+  }
+
+  // prefixes of chunks from the initial frame
+  MCPY(W,cR[0]);
+  VCPY(V,cT[0]);
+  FOR(k,1,nt) {
+    const num_t *Ri = R+NN*(bnd[k]-1), *Ti = T+N*(bnd[k]-1);
+    MCPY(Ri,cR[k]);
+    VCPY(Ti,cT[k]);
+    srv_cmp(cR[k-1], cT[k-1], cR[k], cT[k]);
+  }
+
+  // global frames
+  #pragma omp parallel for if (nt > 1)
+  FOR(k,nt) FOR(i,bnd[k],bnd[k+1]) srv_cmp(cR[k], cT[k], R+NN*i, T+N*i);
+
+  // angles (theta, phi, psi) from rotzxy, with continuity (see rangle)
+  FOR(i,1,n+1) {
+    num_t a[N];
+    mad_mat_torotyxz(W+NN*i, a, TRUE);
+    num_t the = -a[1], phi = a[0], psi = -a[2];
+    the += M_2PI*round((A[N*(i-1)+0]-the)/M_2PI);
+    psi += M_2PI*round((A[N*(i-1)+2]-psi)/M_2PI);
+    A[N*i+0] = the, A[N*i+1] = phi, A[N*i+2] = psi;
+  }
+}
+
+#undef N
@@ -155,6 +155,23 @@ void  mad_mat_torotq   (const num_t x[3*3],       num_t q[4], log_t inv);
 void  mad_mat_rtbar    (      num_t Rb[3*3],       num_t Tb[3], num_t el, num_t ang, num_t tlt,
                         const num_t R_[3*3], const num_t T [3]);
 
+// survey (batched), g[10n] = packed elements geometry, V, W, A have n+1 rows
+void  mad_mat_survey   (const num_t g[], ssz_t n, num_t V[], num_t W[], num_t A[]);
+
+// orbit correction
+void  mad_mat_orm       (      num_t a[], const num_t bm[], const num_t mm[], const num_t bc[], const num_t mc[],
+                         const idx_t jc_[], ssz_t m, ssz_t n, ssz_t lda, num_t nu, log_t ring);
+int   mad_mat_rqr       (const num_t a[],       num_t r[], ssz_t m, ssz_t n);   // R of A=QR
+void  mad_mat_rqr_remcol(      num_t r[],       idx_t k  ,          ssz_t n);   // A without column k
+int   mad_mat_rqr_remrow(      num_t r[], const num_t v[],          ssz_t n);   // A without row v
+int   mad_mat_rqr_solve (const num_t a[], const num_t r[], const num_t b[], num_t x[],
+                         ssz_t m, ssz_t n, num_t rcond);                         // min|b-ax| (R'R)
+
+// closed orbit (batched Newton)
+ssz_t mad_mat_conewton  (const num_t y[], const idx_t ic[], num_t x0[], const num_t dh[],
+                         const num_t o1[6], num_t dx[], idx_t st[], idx_t rk[], num_t r_[],
+                         ssz_t n, log_t tp, num_t tol, num_t dptol);
+
 // special flags
 extern int mad_use_madx_micado;
 extern int mad_use_madx_svdcnd;
@@ -399,8 +399,134 @@ void mad_num_randjump (prng_state_t *restrict st)
   s[3] = s3;
 }
 
+void mad_num_rand_fill (prng_state_t *restrict st, num_t r[], ssz_t n, log_t gauss)
+{
+  assert(st && r);
+  if (!gauss) { FOR(i,n) r[i] = mad_num_rand(st); return; }
+
+  // Box-Muller transformation (basic form), two uniforms per pair of normals
+  FOR(i,0,n,2) {
+    const num_t a = M_2PI*mad_num_rand(st);
+    const num_t w = sqrt(-2*log(1-mad_num_rand(st)));
+    r[i] = w*cos(a); if (i+1 < n) r[i+1] = w*sin(a);
+  }
+}
+
 #undef N
 
+// -- RNG Philox4x32-10 -------------------------------------------------------o
+
+// Counter-based generator from J. Salmon et al., "Parallel Random Numbers: As
+// Easy as 1, 2, 3", SC11. Each 128 bits block is a pure function of the key
+// (seed) and of the counter (draw, elem, turn, id), thus any stream can be
+// (re)generated in any order by any thread with bitwise identical results.
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+
+static inline void
+philox (const u32_t key[2], const u32_t ctr[4], u64_t r[2])
+{
+  u32_t k0 = key[0], k1 = key[1];
+  u32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+
+  FOR(i,10) {
+    const u64_t p0 = (u64_t)PHILOX_M0 * c0;
+    const u64_t p1 = (u64_t)PHILOX_M1 * c2;
+    c0 = (u32_t)(p1 >> 32) ^ c1 ^ k0;
+    c1 = (u32_t) p1;
+    c2 = (u32_t)(p0 >> 32) ^ c3 ^ k1;
+    c3 = (u32_t) p0;
+    k0 += PHILOX_W0, k1 += PHILOX_W1;
+  }
+
+  r[0] = (u64_t)c1 << 32 | c0;
+  r[1] = (u64_t)c3 << 32 | c2;
+}
+
+static inline num_t
+u64tonum (u64_t x)
+{
+  const union numbit n = { .u = 0x3ffULL << 52 | x >> 12 };
+  return n.d - 1; // [1.,2.) -> [0.,1.)
+}
+
+u64_t mad_num_crandi (crng_state_t *restrict st)
+{
+  if (st->n == 2) {
+    philox(st->key, st->ctr, st->buf);
+    st->ctr[0]++, st->n = 0;
+  }
+  return st->buf[st->n++]; // number within [0,ULLONG_MAX]
+}
+
+num_t mad_num_crand (crng_state_t *restrict st)
+{
+  return u64tonum(mad_num_crandi(st));
+}
+
+void mad_num_crandseed (crng_state_t *restrict st, num_t seed)
+{
+  const union numbit n = { .d = seed };
+  const u64_t k = splitmix64(n.u);
+  st->key[0] = (u32_t)k, st->key[1] = (u32_t)(k >> 32);
+  mad_num_crandstrm(st, 0, 0, 0);
+}
+
+void mad_num_crandstrm (crng_state_t *restrict st, u32_t id, u32_t turn, u32_t elem)
+{
+  st->ctr[0] = 0, st->ctr[1] = elem, st->ctr[2] = turn, st->ctr[3] = id;
+  st->n = 2;
+}
+
+void mad_num_crand_fill (crng_state_t *restrict st, num_t r[], ssz_t n, log_t gauss)
+{
+  assert(st && r);
+  if (n <= 0) return;
+
+  const u32_t key[2] = { st->key[0], st->key[1] };
+  const u32_t c0 = st->ctr[0], c1 = st->ctr[1], c2 = st->ctr[2], c3 = st->ctr[3];
+
+  if (gauss) { // one block per pair of normals, starting on a fresh block
+    const ssz_t nb = (n+1)/2;
+
+    #pragma omp parallel for if (nb >= 8192)
+    FOR(i,nb) {
+      const u32_t ctr[4] = { c0+i, c1, c2, c3 };
+      u64_t b[2]; philox(key, ctr, b);
+      const num_t a = M_2PI*u64tonum(b[0]);
+      const num_t w = sqrt(-2*log(1-u64tonum(b[1])));
+      r[2*i] = w*cos(a); if (2*i+1 < n) r[2*i+1] = w*sin(a);
+    }
+    st->ctr[0] += nb, st->n = 2;
+    return;
+  }
+
+  // uniforms, same sequence as n calls to mad_num_crand
+  idx_t j = 0;
+  while (st->n < 2 && j < n) r[j++] = u64tonum(st->buf[st->n++]);
+
+  const ssz_t nb = (n-j)/2;
+  num_t *restrict rj = r+j;
+
+  #pragma omp parallel for if (nb >= 8192)
+  FOR(i,nb) {
+    const u32_t ctr[4] = { c0+i, c1, c2, c3 };
+    u64_t b[2]; philox(key, ctr, b);
+    rj[2*i] = u64tonum(b[0]), rj[2*i+1] = u64tonum(b[1]);
+  }
+  st->ctr[0] += nb, j += 2*nb;
+
+  if (j < n) r[j] = mad_num_crand(st);
+}
+
+#undef PHILOX_M0
+#undef PHILOX_M1
+#undef PHILOX_W0
+#undef PHILOX_W1
+
 // -- RNG MADX ----------------------------------------------------------------o
 
 #define MAX_RAND 1000000000
@@ -126,12 +126,30 @@ num_t mad_num_rand     (prng_state_t*);             // [0.,1.)
 u64_t mad_num_randi    (prng_state_t*);             // [0,ULLONG_MAX]
 void  mad_num_randjump (prng_state_t*);
 void  mad_num_randseed (prng_state_t*, num_t seed);
+void  mad_num_rand_fill(prng_state_t*, num_t r[], ssz_t n, log_t gauss);
 
 // --- private
 struct prng_state_ {
   u64_t s[4];
 };
 
+// MAD counter-based random number generator (Philox4x32-10)
+// streams are keyed by (seed, id, turn, elem) and independent of threads order
+typedef struct crng_state_ crng_state_t;
+
+num_t mad_num_crand      (crng_state_t*);           // [0.,1.)
+u64_t mad_num_crandi     (crng_state_t*);           // [0,ULLONG_MAX]
+void  mad_num_crandseed  (crng_state_t*, num_t seed);
+void  mad_num_crandstrm  (crng_state_t*, u32_t id, u32_t turn, u32_t elem);
+void  mad_num_crand_fill (crng_state_t*, num_t r[], ssz_t n, log_t gauss);
+
+// --- private
+struct crng_state_ {
+  u32_t key[2], ctr[4]; // ctr = { draw, elem, turn, id }
+  u64_t buf[2];
+  idx_t n;
+};
+
 // MAD-X pseudo-random number generator
 typedef struct xrng_state_ xrng_state_t;
 
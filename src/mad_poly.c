@@ -16,8 +16,10 @@
  o-----------------------------------------------------------------------------o
 */
 
+#include <math.h>
 #include <assert.h>
 
+#include "mad_log.h"
 #include "mad_poly.h"
 
 // Check if a point p is inside a closed polygon v (vector of points)
@@ -40,10 +42,176 @@ mad_pol_inside(num_t px, num_t py, ssz_t n, const num_t vx[n], const num_t vy[n]
   int wn = 0; // the winding number counter
 
   for (ssz_t i=0; i < n-1; i++) {
-    if (vy[i  ] <= py && vy[i+1] > py && is_left(px, py, vx, vy, i) > 0) ++wn;
+    if (vy[i  ] <= py && vy[i+1] >  py && is_left(px, py, vx, vy, i) > 0) ++wn;
     else
-    if (vy[i+1] <= py &&                 is_left(px, py, vx, vy, i) < 0) --wn;
+    if (vy[i  ] >  py && vy[i+1] <= py && is_left(px, py, vx, vy, i) < 0) --wn;
   }
 
-  return !wn;
+  return wn != 0;
+}
+
+// --- aperture checks --------------------------------------------------------o
+
+// Check a bunch of points (x,y) against an aperture shape, all at once.
+// Input:   kind  = aperture kind (see mad_poly.h, must be consistent with
+//                  madl_aper.mad), ap = aperture parameters (up to 4),
+//          ang, dx, dy = tilt and offsets of the aperture frame,
+//          n, x, y = SoA bunch of n points.
+// Output:  lost = mask of lost points.
+// Return:  number of lost points.
+// Note:    loops are branch-free to allow vectorization by the compiler,
+//          degenerated shapes (i.e. null semi-axis) are handled explicitly as
+//          the limit of the shape, not through inf or nan (-ffast-math).
+
+#define APE_LOST() \
+  do { FOR(i,n) lost[i] = TRUE; return n; } while(0)
+
+#define APE_LOOP(INSIDE) \
+  FOR(i,n) { \
+    const num_t x = fabs(ca*x_[i] + sa*y_[i] - dx); \
+    const num_t y = fabs(ca*y_[i] - sa*x_[i] - dy); \
+    const log_t out = !(INSIDE); \
+    lost[i] = out, nl += out; \
+  }
+
+ssz_t
+mad_pol_aper (int kind, const num_t ap[4], num_t ang, num_t dx, num_t dy,
+              ssz_t n, const num_t x_[n], const num_t y_[n], log_t lost[n])
+{
+  assert(ap && x_ && y_ && lost);
+  const num_t ca = cos(ang), sa = sin(ang);
+  const num_t a1 = ap[0], a2 = ap[1], a3 = ap[2], a4 = ap[3];
+  ssz_t nl = 0;
+
+  switch (kind) {
+  case mad_ape_square:
+    APE_LOOP((x < a1) & (y < a1)); break;
+
+  case mad_ape_rectangle:
+    APE_LOOP((x < a1) & (y < a2)); break;
+
+  case mad_ape_circle: {
+    const num_t r2 = a1*a1;
+    APE_LOOP(x*x + y*y < r2); } break;
+
+  case mad_ape_ellipse: {
+    if (a1 <= 0 || a2 <= 0) APE_LOST(); // empty ellipse
+    const num_t ia = 1/a1, ib = 1/a2;
+    APE_LOOP((x*ia)*(x*ia) + (y*ib)*(y*ib) < 1); } break;
+
+  case mad_ape_rectcircle: {
+    const num_t r2 = a3*a3;
+    APE_LOOP((x < a1) & (y < a2) & (x*x + y*y < r2)); } break;
+
+  case mad_ape_rectellipse: {
+    if (a3 <= 0 || a4 <= 0) APE_LOST(); // empty ellipse
+    const num_t ia = 1/a3, ib = 1/a4;
+    APE_LOOP((x < a1) & (y < a2) & ((x*ia)*(x*ia) + (y*ib)*(y*ib) < 1)); } break;
+
+  case mad_ape_racetrack: {
+    if (a3 <= 0 || a4 <= 0) { // no rounded corner
+      APE_LOOP((x < a1) & (y < a2)); break;
+    }
+    const num_t cx = a1-a3, cy = a2-a4, ia = 1/a3, ib = 1/a4;
+    APE_LOOP((x < a1) & (y < a2) & ((x < cx) | (y < cy) |
+             (((x-cx)*ia)*((x-cx)*ia) + ((y-cy)*ib)*((y-cy)*ib) < 1))); } break;
+
+  case mad_ape_octagon: {
+    if (a3 <= 0) APE_LOST(); // vertical cut at a1
+    const num_t cx = a1-a3, sl = a4/a3;
+    APE_LOOP((x < a1) & (y < a2) & (y < (x-cx)*sl + a2)); } break;
+
+  default:
+    error("unsupported aperture kind %d", kind);
+  }
+
+  return nl;
+}
+
+#undef APE_LOOP
+#undef APE_LOST
+
+// Check a bunch of points (x,y) against a closed polygon (vx,vy), with an
+//   optional shape (mkind >= 0) used as fast inner aperture, i.e. points
+//   inside the shape are not checked against the polygon.
+// Return:  number of lost points, see mad_pol_aper.
+
+ssz_t
+mad_pol_aperpoly (ssz_t nv, const num_t vx[nv], const num_t vy[nv],
+                  int mkind, const num_t map[4], num_t ang, num_t dx, num_t dy,
+                  ssz_t n, const num_t x[n], const num_t y[n], log_t lost[n])
+{
+  assert(vx && vy && x && y && lost);
+  ensure(nv > 1 && vx[0] == vx[nv-1] && vy[0] == vy[nv-1],
+         "invalid polygon (not closed)");
+
+  if (mkind >= 0) mad_pol_aper(mkind, map, ang, dx, dy, n, x, y, lost);
+  else FOR(i,n) lost[i] = TRUE;
+
+  const num_t ca = cos(ang), sa = sin(ang);
+  ssz_t nl = 0;
+
+  FOR(i,n) {
+    if (lost[i]) {
+      const num_t px = ca*x[i] + sa*y[i] - dx;
+      const num_t py = ca*y[i] - sa*x[i] - dy;
+      lost[i] = !mad_pol_inside(px, py, nv, vx, vy);
+    }
+    nl += lost[i];
+  }
+
+  return nl;
+}
+
+// Check a bunch of points (x,px,y,py) against a bounding box ap.
+// Return:  number of lost points, see mad_pol_aper.
+
+ssz_t
+mad_pol_aperbbox (const num_t ap[4], ssz_t n, const num_t x [n], const num_t px[n],
+                                              const num_t y [n], const num_t py[n],
+                                              log_t lost[n])
+{
+  assert(ap && x && px && y && py && lost);
+  const num_t a1 = ap[0], a2 = ap[1], a3 = ap[2], a4 = ap[3];
+  ssz_t nl = 0;
+
+  FOR(i,n) {
+    const log_t out = !((fabs(x [i]) < a1) & (fabs(px[i]) < a2) &
+                        (fabs(y [i]) < a3) & (fabs(py[i]) < a4));
+    lost[i] = out, nl += out;
+  }
+
+  return nl;
+}
+
+// Compact a SoA bunch of nc columns v[nc][n] w.r.t. the mask of lost points,
+//   by swapping each lost point with the last alive one (i.e. as the tracking
+//   does for particles). The mask is permuted accordingly.
+// Output:  pos = positions of the lost points when swapped, in order of loss
+//                (optional), to replay the permutation on the tracked objects,
+//          buf = coordinates of the lost points (optional, row-major, nl x nc,
+//                in order of loss).
+// Return:  number of remaining (alive) points.
+
+ssz_t
+mad_pol_compact (ssz_t n, ssz_t nc, num_t *v[nc], log_t lost[n], idx_t pos[],
+                 num_t buf[])
+{
+  assert(v && lost);
+  ssz_t i = 0;
+  num_t t;
+  log_t l;
+
+  while (i < n) {
+    if (!lost[i]) { ++i; continue; }
+    --n;
+    if (pos) *pos++ = i;
+    FOR(j,nc) {
+      if (buf) *buf++ = v[j][i];
+      SWAP(v[j][i], v[j][n], t);
+    }
+    SWAP(lost[i], lost[n], l);
+  }
+
+  return n;
 }
@@ -20,6 +20,7 @@
 
   Purpose:
   - wrappers around functions of polygons for LuaJIT
+  - batched checks of aperture shapes over SoA bunches
 
  o-----------------------------------------------------------------------------o
  */
@@ -31,6 +32,24 @@
 // polygon contains a point? (winding number algo)
 log_t mad_pol_inside(num_t px, num_t py, ssz_t n, const num_t vx[], const num_t vy[]);
 
+// aperture kinds (must be consistent with madl_aper.mad)
+enum { mad_ape_square, mad_ape_rectangle, mad_ape_circle, mad_ape_ellipse,
+       mad_ape_rectcircle, mad_ape_rectellipse, mad_ape_racetrack,
+       mad_ape_octagon };
+
+// batched aperture checks (return the number of lost points)
+ssz_t mad_pol_aper     (int kind, const num_t ap[4], num_t ang, num_t dx, num_t dy,
+                        ssz_t n, const num_t x[], const num_t y[], log_t lost[]);
+ssz_t mad_pol_aperpoly (ssz_t nv, const num_t vx[], const num_t vy[],
+                        int mkind, const num_t map[4], num_t ang, num_t dx, num_t dy,
+                        ssz_t n, const num_t x[], const num_t y[], log_t lost[]);
+ssz_t mad_pol_aperbbox (const num_t ap[4], ssz_t n, const num_t x[], const num_t px[],
+                        const num_t y[], const num_t py[], log_t lost[]);
+
+// compact SoA bunch w.r.t. lost points (return the number of alive points)
+ssz_t mad_pol_compact  (ssz_t n, ssz_t nc, num_t *v[], log_t lost[], idx_t pos[],
+                        num_t buf[]);
+
 // ----------------------------------------------------------------------------o
 
 #endif // MAD_POLY_H
@@ -17,8 +17,12 @@
 */
 
 #include <math.h>
+#include <string.h>
+#include <assert.h>
 
+#include "mad_mem.h"
 #include "mad_log.h"
+#include "mad_cst.h"
 #include "mad_rad.h"
 
 // --- InvSynFracInt ----------------------------------------------------------o
@@ -38,60 +42,60 @@ Chebyshev (num_t a, num_t b, const num_t c[], int m, num_t x)
   return y*d - dd + 0.5*c[0];
 }
 
+// from 0 to 0.7
+static const num_t aa1=0, aa2=0.7;
+static const num_t cheb1[] = {
+  1.22371665676046468821,0.108956475422163837267,0.0383328524358594396134,0.00759138369340257753721,
+  0.00205712048644963340914,0.000497810783280019308661,0.000130743691810302187818,0.0000338168760220395409734,
+  8.97049680900520817728e-6,2.38685472794452241466e-6,6.41923109149104165049e-7,1.73549898982749277843e-7,
+  4.72145949240790029153e-8,1.29039866111999149636e-8,3.5422080787089834182e-9,9.7594757336403784905e-10,
+  2.6979510184976065731e-10,7.480422622550977077e-11,2.079598176402699913e-11,5.79533622220841193e-12,
+  1.61856011449276096e-12,4.529450993473807e-13,1.2698603951096606e-13,3.566117394511206e-14,1.00301587494091e-14,
+  2.82515346447219e-15,7.9680747949792e-16};
+
+// from 0.7 to 0.9132260271183847
+static const num_t aa3=0.9132260271183847;
+static const num_t cheb2[] = {
+  1.1139496701107756,0.3523967429328067,0.0713849171926623,0.01475818043595387,0.003381255637322462,
+  0.0008228057599452224,0.00020785506681254216,0.00005390169253706556,0.000014250571923902464,3.823880733161044e-6,
+  1.0381966089136036e-6,2.8457557457837253e-7,7.86223332179956e-8,2.1866609342508474e-8,6.116186259857143e-9,
+  1.7191233618437565e-9,4.852755117740807e-10,1.3749966961763457e-10,3.908961987062447e-11,1.1146253766895824e-11,
+  3.1868887323415814e-12,9.134319791300977e-13,2.6211077371181566e-13,7.588643377757906e-14,2.1528376972619e-14,
+  6.030906040404772e-15,1.9549163926819867e-15};
+
+// Chebyshev with exp/log  scale
+// a = -Log[1 - SynFracInt[1]]; b = -Log[1 - SynFracInt[7]];
+static const num_t aa4=2.4444485538746025480, aa5=9.3830728608909477079;
+static const num_t cheb3[] = {
+  1.2292683840435586977,0.160353449247864455879,-0.0353559911947559448721,0.00776901561223573936985,
+  -0.00165886451971685133259,0.000335719118906954279467,-0.0000617184951079161143187,9.23534039743246708256e-6,
+  -6.06747198795168022842e-7,-3.07934045961999778094e-7,1.98818772614682367781e-7,-8.13909971567720135413e-8,
+  2.84298174969641838618e-8,-9.12829766621316063548e-9,2.77713868004820551077e-9,-8.13032767247834023165e-10,
+  2.31128525568385247392e-10,-6.41796873254200220876e-11,1.74815310473323361543e-11,-4.68653536933392363045e-12,
+  1.24016595805520752748e-12,-3.24839432979935522159e-13,8.44601465226513952994e-14,-2.18647276044246803998e-14,
+  5.65407548745690689978e-15,-1.46553625917463067508e-15,3.82059606377570462276e-16,-1.00457896653436912508e-16};
+
+static const num_t aa6=33.122936966163038145;
+static const num_t cheb4[] = {
+  1.69342658227676741765,0.0742766400841232319225,-0.019337880608635717358,0.00516065527473364110491,
+  -0.00139342012990307729473,0.000378549864052022522193,-0.000103167085583785340215,0.0000281543441271412178337,
+  -7.68409742018258198651e-6,2.09543221890204537392e-6,-5.70493140367526282946e-7,1.54961164548564906446e-7,
+  -4.19665599629607704794e-8,1.13239680054166507038e-8,-3.04223563379021441863e-9,8.13073745977562957997e-10,
+  -2.15969415476814981374e-10,5.69472105972525594811e-11,-1.48844799572430829499e-11,3.84901514438304484973e-12,
+  -9.82222575944247161834e-13,2.46468329208292208183e-13,-6.04953826265982691612e-14,1.44055805710671611984e-14,
+  -3.28200813577388740722e-15,6.96566359173765367675e-16,-1.294122794852896275e-16};
+
+enum { // avoid array size error
+  ncheb1 = sizeof cheb1/sizeof cheb1[0],
+  ncheb2 = sizeof cheb2/sizeof cheb2[0],
+  ncheb3 = sizeof cheb3/sizeof cheb3[0],
+  ncheb4 = sizeof cheb4/sizeof cheb4[0] };
+
 num_t
 mad_rad_InvSynFracInt (num_t x)
 {
   ensure(x >= 0 && x < 1, "invalid argument #1 (0 <= x < 1 expected)");
 
-  // from 0 to 0.7
-  static const num_t aa1=0, aa2=0.7;
-  static const num_t cheb1[] = {
-    1.22371665676046468821,0.108956475422163837267,0.0383328524358594396134,0.00759138369340257753721,
-    0.00205712048644963340914,0.000497810783280019308661,0.000130743691810302187818,0.0000338168760220395409734,
-    8.97049680900520817728e-6,2.38685472794452241466e-6,6.41923109149104165049e-7,1.73549898982749277843e-7,
-    4.72145949240790029153e-8,1.29039866111999149636e-8,3.5422080787089834182e-9,9.7594757336403784905e-10,
-    2.6979510184976065731e-10,7.480422622550977077e-11,2.079598176402699913e-11,5.79533622220841193e-12,
-    1.61856011449276096e-12,4.529450993473807e-13,1.2698603951096606e-13,3.566117394511206e-14,1.00301587494091e-14,
-    2.82515346447219e-15,7.9680747949792e-16};
-
-  // from 0.7 to 0.9132260271183847
-  static const num_t aa3=0.9132260271183847;
-  static const num_t cheb2[] = {
-    1.1139496701107756,0.3523967429328067,0.0713849171926623,0.01475818043595387,0.003381255637322462,
-    0.0008228057599452224,0.00020785506681254216,0.00005390169253706556,0.000014250571923902464,3.823880733161044e-6,
-    1.0381966089136036e-6,2.8457557457837253e-7,7.86223332179956e-8,2.1866609342508474e-8,6.116186259857143e-9,
-    1.7191233618437565e-9,4.852755117740807e-10,1.3749966961763457e-10,3.908961987062447e-11,1.1146253766895824e-11,
-    3.1868887323415814e-12,9.134319791300977e-13,2.6211077371181566e-13,7.588643377757906e-14,2.1528376972619e-14,
-    6.030906040404772e-15,1.9549163926819867e-15};
-
-  // Chebyshev with exp/log  scale
-  // a = -Log[1 - SynFracInt[1]]; b = -Log[1 - SynFracInt[7]];
-  static const num_t aa4=2.4444485538746025480, aa5=9.3830728608909477079;
-  static const num_t cheb3[] = {
-    1.2292683840435586977,0.160353449247864455879,-0.0353559911947559448721,0.00776901561223573936985,
-    -0.00165886451971685133259,0.000335719118906954279467,-0.0000617184951079161143187,9.23534039743246708256e-6,
-    -6.06747198795168022842e-7,-3.07934045961999778094e-7,1.98818772614682367781e-7,-8.13909971567720135413e-8,
-    2.84298174969641838618e-8,-9.12829766621316063548e-9,2.77713868004820551077e-9,-8.13032767247834023165e-10,
-    2.31128525568385247392e-10,-6.41796873254200220876e-11,1.74815310473323361543e-11,-4.68653536933392363045e-12,
-    1.24016595805520752748e-12,-3.24839432979935522159e-13,8.44601465226513952994e-14,-2.18647276044246803998e-14,
-    5.65407548745690689978e-15,-1.46553625917463067508e-15,3.82059606377570462276e-16,-1.00457896653436912508e-16};
-
-  static const num_t aa6=33.122936966163038145;
-  static const num_t cheb4[] = {
-    1.69342658227676741765,0.0742766400841232319225,-0.019337880608635717358,0.00516065527473364110491,
-    -0.00139342012990307729473,0.000378549864052022522193,-0.000103167085583785340215,0.0000281543441271412178337,
-    -7.68409742018258198651e-6,2.09543221890204537392e-6,-5.70493140367526282946e-7,1.54961164548564906446e-7,
-    -4.19665599629607704794e-8,1.13239680054166507038e-8,-3.04223563379021441863e-9,8.13073745977562957997e-10,
-    -2.15969415476814981374e-10,5.69472105972525594811e-11,-1.48844799572430829499e-11,3.84901514438304484973e-12,
-    -9.82222575944247161834e-13,2.46468329208292208183e-13,-6.04953826265982691612e-14,1.44055805710671611984e-14,
-    -3.28200813577388740722e-15,6.96566359173765367675e-16,-1.294122794852896275e-16};
-
-  enum { // avoid array size error
-    ncheb1 = sizeof cheb1/sizeof cheb1[0],
-    ncheb2 = sizeof cheb2/sizeof cheb2[0],
-    ncheb3 = sizeof cheb3/sizeof cheb3[0],
-    ncheb4 = sizeof cheb4/sizeof cheb4[0] };
-
   if(x<aa2)        return x*x*x*Chebyshev(aa1,aa2,cheb1,ncheb1,x);
   if(x<aa3)        return       Chebyshev(aa2,aa3,cheb2,ncheb2,x);
 
@@ -100,6 +104,241 @@ mad_rad_InvSynFracInt (num_t x)
   else                 return y*Chebyshev(aa5,aa6,cheb4,ncheb4,y);
 }
 
+// --- InvSynFracInt (tabulated) ----------------------------------------------o
+
+// The four Chebyshev series above are replaced by piecewise series of low
+// degree on uniform intervals, built once from the full series. The lookup
+// is direct and each evaluation costs a few flops instead of ~27 terms, with
+// a relative difference below 1e-14 to mad_rad_InvSynFracInt. The table is
+// built at load time (~16k evaluations), i.e. before any thread can use it.
+
+enum { syn_nint = 64, syn_ndeg = 8 };
+
+static const struct {
+  num_t a, b;
+  const num_t *c; int m;
+} syn_reg[4] = {
+  { aa1, aa2, cheb1, ncheb1 }, { aa2, aa3, cheb2, ncheb2 },
+  { aa4, aa5, cheb3, ncheb3 }, { aa5, aa6, cheb4, ncheb4 },
+};
+
+static num_t syn_tbl[4][syn_nint][syn_ndeg];
+
+static void __attribute__((constructor))
+syn_mktbl (void)
+{
+  FOR(k,4) {
+    const num_t a = syn_reg[k].a, h = (syn_reg[k].b-a)/syn_nint;
+    FOR(i,syn_nint) {
+      num_t f[syn_ndeg];
+      FOR(j,syn_ndeg) { // Chebyshev nodes of the interval
+        num_t t = cos(M_PI*(j+0.5)/syn_ndeg);
+        f[j] = Chebyshev(syn_reg[k].a, syn_reg[k].b, syn_reg[k].c, syn_reg[k].m,
+                         a + (i+0.5*(t+1))*h);
+      }
+      FOR(l,syn_ndeg) { // discrete Chebyshev transform (c0 halved by Clenshaw)
+        num_t c = 0;
+        FOR(j,syn_ndeg) c += f[j]*cos(M_PI*l*(j+0.5)/syn_ndeg);
+        syn_tbl[k][i][l] = 2*c/syn_ndeg;
+      }
+    }
+  }
+}
+
+static inline num_t
+syn_eval (int k, num_t u)
+{
+  const num_t s = syn_nint/(syn_reg[k].b-syn_reg[k].a);
+  num_t t = (u-syn_reg[k].a)*s;
+  int   i = MIN((int)t, syn_nint-1);
+  return Chebyshev(-1, 1, syn_tbl[k][i], syn_ndeg, 2*(t-i)-1);
+}
+
+static inline num_t
+syn_invcdf (num_t x)
+{
+  if (x < aa2) return x*x*x*syn_eval(0, x);
+  if (x < aa3) return       syn_eval(1, x);
+
+  num_t y = -log1p(-x);
+  if (y < aa5) return y*syn_eval(2, y);
+  if (y < aa6) return y*syn_eval(3, y);
+  return y*Chebyshev(aa5,aa6,cheb4,ncheb4,y); // extrapolation, x > 1-4e-15
+}
+
+void
+mad_rad_InvSynFracIntv (const num_t x[], num_t r[], ssz_t n)
+{
+  assert(x && r);
+
+  idx_t err = 0;
+  #pragma omp parallel for reduction(+:err) if (n >= 8192)
+  FOR(i,n) {
+    err += !(x[i] >= 0 && x[i] < 1);
+    r[i] = syn_invcdf(x[i]);
+  }
+  ensure(!err, "invalid argument #1 (0 <= x < 1 expected)");
+}
+
+// --- photon energies sampler ------------------------------------------------o
+
+void
+mad_rad_syngen (crng_state_t *rng, num_t r[], ssz_t n)
+{
+  assert(rng && r);
+  mad_num_crand_fill(rng, r, n, FALSE);
+  mad_rad_InvSynFracIntv(r, r, n);
+}
+
+void
+mad_rad_syngenp (crng_state_t *rng, const idx_t id[], num_t r[], ssz_t n)
+{
+  assert(rng && id && r);
+
+  #pragma omp parallel for if (n >= 4096)
+  FOR(i,n) {
+    crng_state_t st = *rng;
+    mad_num_crandstrm(&st, id[i], rng->ctr[2], rng->ctr[1]);
+    st.ctr[0] = rng->ctr[0];
+    r[i] = syn_invcdf(mad_num_crand(&st));
+  }
+  rng->ctr[0]++, rng->n = 2;
+}
+
+// --- photons buffer ---------------------------------------------------------o
+
+// Photons are stored by columns and appended at the end of the buffer. Their
+// straight motion is applied in bulk up to the requested s-position, e.g. just
+// before an aperture check, in the frame of the element being crossed.
+
+#define PHB_NUM(F) F(x) F(px) F(y) F(py) F(s) F(s0) F(nrj)
+#define PHB_IDX(F) F(id) F(pid) F(turn) F(eidx)
+
+static void
+phb_resize (phbuf_t *pb, ssz_t nmax)
+{
+#define F(a) pb->a = mad_realloc(pb->a, nmax * sizeof *pb->a);
+  PHB_NUM(F) PHB_IDX(F)
+#undef F
+  pb->nmax = nmax;
+}
+
+phbuf_t*
+mad_rad_phnew (ssz_t nmax)
+{
+  phbuf_t *pb = mad_malloc(sizeof *pb);
+  memset(pb, 0, sizeof *pb);
+  phb_resize(pb, MAX(nmax, 64));
+  return pb;
+}
+
+void
+mad_rad_phdel (phbuf_t *pb)
+{
+  if (!pb) return;
+#define F(a) mad_free(pb->a);
+  PHB_NUM(F) PHB_IDX(F)
+#undef F
+  mad_free(pb);
+}
+
+idx_t
+mad_rad_phadd (phbuf_t *pb, num_t x, num_t px, num_t y, num_t py, num_t s,
+               num_t nrj, idx_t pid, idx_t turn, idx_t eidx)
+{
+  assert(pb);
+  if (pb->n == pb->nmax) phb_resize(pb, 2*pb->nmax);
+  idx_t i = pb->n++;
+  pb->x  [i] = x  , pb->px [i] = px, pb->y[i] = y, pb->py[i] = py;
+  pb->s  [i] = s  , pb->s0 [i] = s , pb->nrj [i] = nrj;
+  pb->id [i] = ++pb->nid, pb->pid[i] = pid, pb->turn[i] = turn, pb->eidx[i] = eidx;
+  return i;
+}
+
+void
+mad_rad_phtrk (phbuf_t *pb, num_t s0, num_t s1, num_t h, num_t tlt)
+{
+  assert(pb);
+  const num_t ct = cos(tlt), st = sin(tlt);
+  const int   tl = fabs(tlt) >= 1e-15, cv = fabs(h) >= 1e-12;
+
+  #pragma omp parallel for if (pb->n >= 10000)
+  FOR(i,pb->n) {
+    num_t s = pb->s[i];
+    if (s >= s1) continue;
+
+    num_t x = pb->x[i], px = pb->px[i], y = pb->y[i], py = pb->py[i];
+    num_t pz = sqrt(1 - px*px - py*py);
+
+    // straight up to the entry of the element, see strex_drift0
+    if (s < s0 || !cv) {
+      num_t l = (cv ? s0 : s1) - s;
+      x += px*l/pz, y += py*l/pz, s += l;
+    }
+
+    // curved frame up to s1, see curex_drift0
+    if (cv && s < s1) {
+      if (tl) {
+        num_t xt = ct*x +st*y , yt = ct*y -st*x;
+        num_t pxt= ct*px+st*py, pyt= ct*py-st*px;
+        x = xt, y = yt, px = pxt, py = pyt;
+      }
+      num_t rho = 1/h, a = h*(s1-s), ca = cos(a), sa = sin(a), sa2 = sin(a/2);
+      num_t pxt = px/pz, ptt = ca - sa*pxt;
+      if (ptt > 0) {
+        num_t pst = (x+rho)*sa/(pz*ptt);
+        x  = (x + rho*(2*sa2*sa2 + sa*pxt))/ptt;
+        px = ca*px + sa*pz;
+        y += pst*py;
+      } else x = copysign(1/mad_cst_MINLEN, h); // never reaches s1, lost
+      if (tl) {
+        num_t xt = ct*x -st*y , yt = ct*y +st*x;
+        num_t pxt= ct*px-st*py, pyt= ct*py+st*px;
+        x = xt, y = yt, px = pxt, py = pyt;
+      }
+      s = s1;
+    }
+    pb->x[i] = x, pb->px[i] = px, pb->y[i] = y, pb->py[i] = py, pb->s[i] = s;
+  }
+}
+
+ssz_t
+mad_rad_phdrop (phbuf_t *pb, const log_t lost[], phbuf_t *lpb)
+{
+  assert(pb && lost);
+  ssz_t j = 0, n = pb->n;
+  FOR(i,n) {
+    if (lost[i]) {
+      if (lpb) {
+        if (lpb->n == lpb->nmax) phb_resize(lpb, 2*lpb->nmax);
+#define F(a) lpb->a[lpb->n] = pb->a[i];
+        PHB_NUM(F) PHB_IDX(F)
+#undef F
+        lpb->n++;
+      }
+      continue;
+    }
+    if (i != j) {
+#define F(a) pb->a[j] = pb->a[i];
+      PHB_NUM(F) PHB_IDX(F)
+#undef F
+    }
+    j++;
+  }
+  pb->n = j;
+  return n-j;
+}
+
+void
+mad_rad_phshift (phbuf_t *pb, num_t ds)
+{
+  assert(pb);
+  FOR(i,pb->n) pb->s[i] += ds;
+}
+
+#undef PHB_NUM
+#undef PHB_IDX
+
 #if 0
 // Obsolete code not used, adapted from Placet (courtesy A. Latina)
 
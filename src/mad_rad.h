@@ -27,11 +27,38 @@
  o-----------------------------------------------------------------------------o
  */
 
-#include "mad_def.h"
+#include "mad_num.h"
 
 // --- interface --------------------------------------------------------------o
 
-num_t mad_rad_InvSynFracInt (num_t x); // HBU 2007
+num_t mad_rad_InvSynFracInt  (num_t x); // HBU 2007
+void  mad_rad_InvSynFracIntv (const num_t x[], num_t r[], ssz_t n); // tabulated
+
+// photon energies in unit of critical energy, drawn from the current stream
+void  mad_rad_syngen  (crng_state_t *rng,                   num_t r[], ssz_t n);
+// one photon energy per particle id, drawn from the streams (id, turn, elem)
+void  mad_rad_syngenp (crng_state_t *rng, const idx_t id[], num_t r[], ssz_t n);
+
+// photons buffer (SoA, append-only, transported in bulk)
+typedef struct phbuf_ phbuf_t;
+
+phbuf_t* mad_rad_phnew   (ssz_t nmax);
+void     mad_rad_phdel   (phbuf_t *pb);
+idx_t    mad_rad_phadd   (phbuf_t *pb, num_t x, num_t px, num_t y, num_t py,
+                          num_t s, num_t nrj, idx_t pid, idx_t turn, idx_t eidx);
+void     mad_rad_phtrk   (phbuf_t *pb, num_t s0, num_t s1, num_t h, num_t tlt);
+ssz_t    mad_rad_phdrop  (phbuf_t *pb, const log_t lost[], phbuf_t *lpb_);
+void     mad_rad_phshift (phbuf_t *pb, num_t ds);
+
+// ----------------------------------------------------------------------------o
+
+struct phbuf_ {
+  ssz_t  n, nmax;               // number of photons, capacity
+  idx_t  nid;                   // last photon id
+  num_t *x, *px, *y, *py;       // local coordinates (px, py are angles)
+  num_t *s, *s0, *nrj;          // current and emission s-position [m], energy [GeV]
+  idx_t *id, *pid, *turn, *eidx;// photon and parent ids, emission turn and element
+};
 
 // ----------------------------------------------------------------------------o
 
@@ -234,3 +234,28 @@ mad_str_ident (str_t str, ssz_t arg[4])
 
   return str;
 }
+
+u64_t
+mad_str_hash (str_t str, ssz_t len, u64_t seed)
+{
+  assert(str);
+  const unsigned char *s = (const unsigned char*)str;
+  u64_t h = 14695981039346656037ull ^ seed; // FNV-1a, 64 bit
+
+  // 4 independent lanes to break the multiply dependency chain
+  u64_t h1 = h, h2 = h^1, h3 = h^2, h4 = h^3;
+  ssz_t i = 0;
+  for (; i+4 <= len; i += 4) {
+    h1 = (h1 ^ s[i  ]) * 1099511628211ull;
+    h2 = (h2 ^ s[i+1]) * 1099511628211ull;
+    h3 = (h3 ^ s[i+2]) * 1099511628211ull;
+    h4 = (h4 ^ s[i+3]) * 1099511628211ull;
+  }
+  for (; i < len; i++) h1 = (h1 ^ s[i]) * 1099511628211ull;
+
+  h = h1;
+  h = (h ^ h2) * 1099511628211ull;
+  h = (h ^ h3) * 1099511628211ull;
+  h = (h ^ h4) * 1099511628211ull;
+  return (h ^ (u64_t)len) * 1099511628211ull;
+}
@@ -20,6 +20,7 @@
 
   Purpose:
   - extra functions of fast string manipulation.
+  - content hash of strings (e.g. cache keys), not cryptographic.
 
  o-----------------------------------------------------------------------------o
  */
@@ -34,6 +35,7 @@ str_t mad_str_ident   (str_t str, ssz_t arg[4]);
 str_t mad_str_bracket (str_t str, ssz_t arg[6]);
 str_t mad_str_quote   (str_t str, ssz_t arg[5], log_t sq);
 str_t mad_str_split   (str_t str, ssz_t arg[4], str_t sep);
+u64_t mad_str_hash    (str_t str, ssz_t len, u64_t seed);
 
 // ----------------------------------------------------------------------------o
 
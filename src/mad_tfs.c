@@ -0,0 +1,400 @@
+/*
+ o-----------------------------------------------------------------------------o
+ |
+ | TFS module implementation
+ |
+ | Methodical Accelerator Design - Copyright (c) 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o-----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o-----------------------------------------------------------------------------o
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include "mad_mem.h"
+#include "mad_tfs.h"
+
+#ifdef POSIX_VERSION
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// --- types ------------------------------------------------------------------o
+
+struct tfs_ {
+  const char *dat;      // file content (mapped or read)
+  size_t      len;      // file length
+  size_t      hlen;     // header length (i.e. rows offset)
+  ssz_t       nr, nc;   // number of rows and columns
+  size_t     *pos;      // cells position      [nr*nc]
+  idx_t      *siz;      // cells length        [nr*nc]
+  num_t      *num;      // cells as number     [nr*nc]
+  log_t      *isn;      // cells is a number   [nr*nc]
+};
+
+// --- helpers ----------------------------------------------------------------o
+
+static inline log_t
+is_blank (char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline log_t
+is_empty (const char *s, size_t i, size_t e)
+{
+  while (i < e && is_blank(s[i])) ++i;
+  return i == e;
+}
+
+static inline size_t
+eol (const char *s, size_t i, size_t e) // end of line (excluded)
+{
+  const char *p = memchr(s+i, '\n', e-i);
+  return p ? (size_t)(p-s) : e;
+}
+
+// next token in [i,e), separators are blanks outside quotes, see strsplitall
+static inline size_t
+next_tok (const char *s, size_t i, size_t e, size_t *b)
+{
+  while (i < e && is_blank(s[i])) ++i;
+  *b = i;
+  while (i < e && !is_blank(s[i])) {
+    if (s[i] == '"' || s[i] == '\'') {
+      const char q = s[i++];
+      while (i < e && s[i] != q) i += 1 + (s[i] == '\\' && i+1 < e);
+    }
+    i += i < e;
+  }
+  return i;
+}
+
+// strict decimal number (i.e. no inf, nan or hex), as written by mtable
+static inline log_t
+str2num (const char *s, idx_t n, num_t *x)
+{
+  char buf[64], *end;
+  idx_t i = 0, nd = 0;
+  if (n <= 0 || n >= (idx_t)sizeof buf) return FALSE;
+  if (s[i] == '+' || s[i] == '-') ++i;
+  while (i < n && s[i] >= '0' && s[i] <= '9') ++i, ++nd;
+  if (i < n && s[i] == '.') {
+    ++i;
+    while (i < n && s[i] >= '0' && s[i] <= '9') ++i, ++nd;
+  }
+  if (!nd) return FALSE;
+  if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+    ++i, nd = 0;
+    if (i < n && (s[i] == '+' || s[i] == '-')) ++i;
+    while (i < n && s[i] >= '0' && s[i] <= '9') ++i, ++nd;
+    if (!nd) return FALSE;
+  }
+  if (i != n) return FALSE;
+  memcpy(buf, s, n), buf[n] = 0;
+  *x = strtod(buf, &end);
+  return end == buf+n;
+}
+
+// --- mapping ----------------------------------------------------------------o
+
+ptr_t
+mad_tfs_map (str_t fname, size_t *len)
+{
+  assert(fname && len);
+  *len = 0;
+
+#ifdef POSIX_VERSION
+  struct stat st;
+  int fd = open(fname, O_RDONLY);
+  if (fd < 0) return NULL;
+  if (fstat(fd, &st) < 0) return close(fd), NULL;
+  if (!st.st_size) return close(fd), "";
+  void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return NULL;
+  *len = st.st_size;
+  return p;
+#else
+  FILE *fp = fopen(fname, "rb");
+  if (!fp) return NULL;
+  fseek(fp, 0, SEEK_END), *len = ftell(fp), fseek(fp, 0, SEEK_SET);
+  char *p = mad_malloc(*len+1);
+  *len = fread(p, 1, *len, fp), p[*len] = 0;
+  fclose(fp);
+  return p;
+#endif
+}
+
+void
+mad_tfs_unmap (ptr_t ptr, size_t len)
+{
+#ifdef POSIX_VERSION
+  if (ptr && len) munmap((void*)ptr, len);
+#else
+  (void)len;
+  mad_free((void*)ptr);
+#endif
+}
+
+// --- reader -----------------------------------------------------------------o
+
+tfs_t*
+mad_tfs_open (str_t fname)
+{
+  assert(fname);
+  tfs_t *t = mad_malloc(sizeof *t);
+  memset(t, 0, sizeof *t);
+
+  t->dat = mad_tfs_map(fname, &t->len);
+  if (!t->dat) return mad_free(t), NULL;
+#ifdef POSIX_VERSION
+  if (t->len) posix_madvise((void*)t->dat, t->len, POSIX_MADV_SEQUENTIAL);
+#endif
+
+  // header ends after the line of columns types ($), if any
+  const char *s = t->dat;
+  size_t i = 0, e = t->len;
+  t->hlen = e;
+  while (i < e) {
+    size_t j = eol(s, i, e), k = i;
+    while (k < j && is_blank(s[k])) ++k;
+    if (k < j && s[k] == '$') { t->hlen = j + (j < e); break; }
+    i = j+1;
+  }
+
+  return t;
+}
+
+void
+mad_tfs_close (tfs_t *t)
+{
+  if (!t) return;
+  mad_tfs_unmap(t->dat, t->len);
+  mad_free(t->pos); mad_free(t->siz);
+  mad_free(t->num); mad_free(t->isn);
+  mad_free(t);
+}
+
+str_t
+mad_tfs_header (const tfs_t *t, ssz_t *len)
+{
+  assert(t && len);
+  *len = t->hlen;
+  return t->dat;
+}
+
+// split rows in parallel (blank lines are skipped), tokenize them and parse
+// cells of numeric columns, return the number of rows or -line if a row has
+// an invalid number of columns.
+
+ssz_t
+mad_tfs_parse (tfs_t *t, ssz_t nc, const log_t isnum[])
+{
+  assert(t && isnum && nc > 0);
+  const char *s = t->dat;
+  const size_t e = t->len;
+  const int nt = omp_get_max_threads();
+  size_t bnd[nt+1];
+  ssz_t  cnt[nt+1];
+
+  // chunks boundaries at lines start
+  bnd[0] = t->hlen, bnd[nt] = e;
+  FOR(k,1,nt) {
+    size_t i = t->hlen + (e - t->hlen) / nt * k;
+    while (i < e && s[i-1] != '\n') ++i;
+    bnd[k] = MAX(i, bnd[k-1]);
+  }
+
+  // count rows per chunk
+  #pragma omp parallel for
+  FOR(k,nt) {
+    ssz_t n = 0;
+    for (size_t i=bnd[k]; i < bnd[k+1];) {
+      size_t j = eol(s, i, bnd[k+1]);
+      n += !is_empty(s, i, j);
+      i = j+1;
+    }
+    cnt[k+1] = n;
+  }
+  cnt[0] = 0;
+  FOR(k,nt) cnt[k+1] += cnt[k];
+
+  const ssz_t nr = cnt[nt];
+  const size_t nn = (size_t)nr*nc;
+  t->nr = nr, t->nc = nc;
+  mad_free(t->pos); t->pos = mad_malloc(MAX(nn,1)*sizeof *t->pos);
+  mad_free(t->siz); t->siz = mad_malloc(MAX(nn,1)*sizeof *t->siz);
+  mad_free(t->num); t->num = mad_malloc(MAX(nn,1)*sizeof *t->num);
+  mad_free(t->isn); t->isn = mad_malloc(MAX(nn,1)*sizeof *t->isn);
+
+  // tokenize rows and parse numbers
+  size_t err = e;
+  #pragma omp parallel for reduction(min:err)
+  FOR(k,nt) {
+    size_t r = cnt[k];
+    for (size_t i=bnd[k]; i < bnd[k+1];) {
+      size_t j = eol(s, i, bnd[k+1]);
+      if (!is_empty(s, i, j)) {
+        size_t b, p = i, c = r*nc;
+        idx_t n = 0;
+        while (1) {
+          p = next_tok(s, p, j, &b);
+          if (b == p) break;
+          if (n < nc) {
+            t->pos[c+n] = b, t->siz[c+n] = p-b;
+            t->isn[c+n] = isnum[n] && str2num(s+b, p-b, t->num+c+n);
+          }
+          ++n;
+        }
+        if (n != nc && i < err) err = i;
+        ++r;
+      }
+      i = j+1;
+    }
+  }
+
+  // invalid row, return -line
+  if (err < e) {
+    ssz_t ln = 1;
+    for (size_t i=0; i < err; i++) ln += s[i] == '\n';
+    return -ln;
+  }
+
+  return nr;
+}
+
+str_t
+mad_tfs_cell (const tfs_t *t, idx_t i, idx_t j, ssz_t *len)
+{
+  assert(t && len);
+  assert(0 <= i && i < t->nr && 0 <= j && j < t->nc);
+  const size_t c = (size_t)i*t->nc + j;
+  *len = t->siz[c];
+  return t->dat + t->pos[c];
+}
+
+log_t
+mad_tfs_num (const tfs_t *t, idx_t i, idx_t j, num_t *x)
+{
+  assert(t && x);
+  assert(0 <= i && i < t->nr && 0 <= j && j < t->nc);
+  const size_t c = (size_t)i*t->nc + j;
+  if (t->isn[c]) *x = t->num[c];
+  return t->isn[c];
+}
+
+// copy the numbers of column j into x (i.e. typed column buffer), return the
+// number of cells that are not numbers (x is partially filled if not zero).
+
+ssz_t
+mad_tfs_numcol (const tfs_t *t, idx_t j, num_t x[])
+{
+  assert(t && x);
+  assert(0 <= j && j < t->nc);
+  ssz_t nn = 0;
+
+  #pragma omp parallel for reduction(+:nn) if (t->nr >= 100000)
+  FOR(i,t->nr) {
+    const size_t c = (size_t)i*t->nc + j;
+    x[i] = t->isn[c] ? t->num[c] : 0, nn += !t->isn[c];
+  }
+
+  return nn;
+}
+
+// --- writer -----------------------------------------------------------------o
+
+struct buf { char *dat; size_t len, cap; };
+
+// -0 -> 0 on the bits, v == 0 and fabs are folded under -ffast-math
+static inline num_t
+unsign0 (num_t v)
+{
+  uint64_t u;
+  memcpy(&u, &v, sizeof u);
+  if (!(u << 1)) u = 0;
+  memcpy(&v, &u, sizeof v);
+  return v;
+}
+
+static inline void
+buf_put (struct buf *b, const char *s, size_t n, size_t w)
+{
+  const size_t m = MAX(n, w);
+  if (b->len + m + 2 > b->cap) {
+    b->cap = MAX(2*b->cap, b->len + m + 2);
+    b->dat = mad_realloc(b->dat, b->cap);
+  }
+  memcpy(b->dat+b->len, s, n);
+  if (m > n) memset(b->dat+b->len+n, ' ', m-n);
+  b->len += m;
+}
+
+// format nr rows of nc columns, cells are numbers num[j][i] formatted with
+// fmt, unless str[j] and str[j][i] are not NULL (i.e. already formatted).
+// Columns are left aligned on cw characters as in mtable write. The returned
+// buffer must be released with mad_free.
+
+str_t
+mad_tfs_fmt (ssz_t nr, ssz_t nc, const num_t *num[], const str_t *str[],
+             str_t fmt, ssz_t cw, ssz_t *len)
+{
+  assert(num && str && fmt && len);
+  const int nt = nr*nc > 10000 ? omp_get_max_threads() : 1;
+  struct buf b[nt];
+  memset(b, 0, sizeof b);
+
+  #pragma omp parallel for if (nt > 1)
+  FOR(k,nt) {
+    const ssz_t i0 = (ssz_t)((size_t)nr*k/nt), i1 = (ssz_t)((size_t)nr*(k+1)/nt);
+    char tmp[64];
+
+    FOR(i,i0,i1) {
+      buf_put(b+k, "  ", 2, 0);
+      FOR(j,nc) {
+        str_t s = str[j] ? str[j][i] : NULL;
+        size_t n;
+        if (s) n = strlen(s);
+        else {
+          num_t v = num[j] ? num[j][i] : 0;
+          v = unsign0(v); // remove sign of -0 (i.e. num2str)
+          int r = snprintf(tmp, sizeof tmp, fmt, v);
+          n = MIN(MAX(r,0), (int)sizeof tmp-1), s = tmp;
+        }
+        if (j < nc-1) buf_put(b+k, s, n, cw), buf_put(b+k, " ", 1, 0);
+        else          buf_put(b+k, s, n, 0 ), buf_put(b+k, "\n", 1, 0);
+      }
+    }
+  }
+
+  // concatenate threads buffers
+  size_t n = 0;
+  FOR(k,nt) n += b[k].len;
+  char *r = mad_malloc(n+1);
+  n = 0;
+  FOR(k,nt) {
+    if (b[k].len) memcpy(r+n, b[k].dat, b[k].len);
+    n += b[k].len;
+    mad_free(b[k].dat);
+  }
+  r[n] = 0, *len = n;
+  return r;
+}
+
+// ----------------------------------------------------------------------------o
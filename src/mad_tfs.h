@@ -0,0 +1,57 @@
+#ifndef MAD_TFS_H
+#define MAD_TFS_H
+
+/*
+ o-----------------------------------------------------------------------------o
+ |
+ | TFS module interface
+ |
+ | Methodical Accelerator Design - Copyright (c) 2016+
+ | Support: http://cern.ch/mad  - mad at cern.ch
+ | Authors: L. Deniau, laurent.deniau at cern.ch
+ | Contrib: -
+ |
+ o-----------------------------------------------------------------------------o
+ | You can redistribute this file and/or modify it under the terms of the GNU
+ | General Public License GPLv3 (or later), as published by the Free Software
+ | Foundation. This file is distributed in the hope that it will be useful, but
+ | WITHOUT ANY WARRANTY OF ANY KIND. See http://gnu.org/licenses for details.
+ o-----------------------------------------------------------------------------o
+
+  Purpose:
+  - fast reader and writer of TFS tables rows for mtable (i.e. the header is
+    still handled by mtable). Files are memory mapped, rows are split and
+    cells are parsed or formatted in parallel.
+  - memory mapping of binary tables (mtb) for mtable, see readbin in mtable.
+
+ o-----------------------------------------------------------------------------o
+ */
+
+#include "mad_def.h"
+
+// --- types ------------------------------------------------------------------o
+
+typedef struct tfs_ tfs_t;
+
+// --- interface --------------------------------------------------------------o
+
+// mapping
+ptr_t  mad_tfs_map    (str_t fname, size_t *len);
+void   mad_tfs_unmap  (ptr_t ptr, size_t len);
+
+// reader
+tfs_t* mad_tfs_open   (str_t fname);
+void   mad_tfs_close  (tfs_t *t);
+str_t  mad_tfs_header (const tfs_t *t, ssz_t *len);
+ssz_t  mad_tfs_parse  (      tfs_t *t, ssz_t nc, const log_t isnum[]);
+str_t  mad_tfs_cell   (const tfs_t *t, idx_t i, idx_t j, ssz_t *len);
+log_t  mad_tfs_num    (const tfs_t *t, idx_t i, idx_t j, num_t *x);
+ssz_t  mad_tfs_numcol (const tfs_t *t, idx_t j, num_t x[]);
+
+// writer
+str_t  mad_tfs_fmt    (ssz_t nr, ssz_t nc, const num_t *num[], const str_t *str[],
+                       str_t fmt, ssz_t cw, ssz_t *len);
+
+// ----------------------------------------------------------------------------o
+
+#endif // MAD_TFS_H
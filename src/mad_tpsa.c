@@ -26,6 +26,8 @@
 #include "mad_mem.h"
 #ifdef    MAD_CTPSA_IMPL
 #include "mad_ctpsa_impl.h"
+#elif defined(MAD_FTPSA_IMPL)
+#include "mad_ftpsa_impl.h"
 #else
 #include "mad_tpsa_impl.h"
 #endif
@@ -210,18 +212,20 @@ FUN(isvalid) (const T *t)
 }
 
 num_t
-FUN(density) (const T *t, num_t stat_[2], log_t reset)
+FUN(density) (const T *t, num_t stat_[4], log_t reset)
 {
   assert(t);
   D *d = (D*)t->d;
 
   if (reset)
-    return d->dst_var = d->dst_mu = d->dst_n = 0;
+    return d->prn_o = d->prn_n = d->dst_var = d->dst_mu = d->dst_n = 0;
 
   if (stat_) {
     num_t nn = MAX(1,d->dst_n);
     stat_[0] = d->dst_mu;
     stat_[1] = sqrt(d->dst_var/nn);
+    stat_[2] = d->prn_n;
+    stat_[3] = d->prn_o;
     return d->dst_n;
   }
 
@@ -67,7 +67,7 @@ ord_t   mad_tpsa_ord     (const tpsa_t *t, log_t   hi_ ); // get mo or hi
 log_t   mad_tpsa_isnul   (const tpsa_t *t);
 log_t   mad_tpsa_isval   (const tpsa_t *t);
 log_t   mad_tpsa_isvalid (const tpsa_t *t);
-num_t   mad_tpsa_density (const tpsa_t *t, num_t stat_[2], log_t reset); // ratio nz/nc in [0] U [lo,hi] or stat
+num_t   mad_tpsa_density (const tpsa_t *t, num_t stat_[4], log_t reset); // ratio nz/nc in [0] U [lo,hi] or stat (mu,sig,#prn coefs,#prn ords)
 
 // initialization / manipulation
 void    mad_tpsa_copy    (const tpsa_t *t, tpsa_t *r);
@@ -114,6 +114,7 @@ void    mad_tpsa_dif     (const tpsa_t *a, const tpsa_t *b, tpsa_t *c); // (a_i-
 void    mad_tpsa_add     (const tpsa_t *a, const tpsa_t *b, tpsa_t *c);
 void    mad_tpsa_sub     (const tpsa_t *a, const tpsa_t *b, tpsa_t *c);
 void    mad_tpsa_mul     (const tpsa_t *a, const tpsa_t *b, tpsa_t *c);
+void    mad_tpsa_mulord  (const tpsa_t *a, const tpsa_t *b, tpsa_t *c, ord_t lo, ord_t hi); // orders [lo,hi] of a*b
 void    mad_tpsa_div     (const tpsa_t *a, const tpsa_t *b, tpsa_t *c);
 void    mad_tpsa_pow     (const tpsa_t *a, const tpsa_t *b, tpsa_t *c);
 void    mad_tpsa_powi    (const tpsa_t *a, int           n, tpsa_t *c);
@@ -168,6 +169,17 @@ void    mad_tpsa_poisbra (const tpsa_t *a, const tpsa_t *b, tpsa_t *c, int nv);
 void    mad_tpsa_taylor  (const tpsa_t *a, ssz_t n, const num_t coef[], tpsa_t *c);
 void    mad_tpsa_taylor_h(const tpsa_t *a, ssz_t n, const num_t coef[], tpsa_t *c); // Horner
 
+// batched functions over GTPSAs sharing the same descriptor (parallel over
+// items), aliasing is only allowed between a[i] and c[i]
+void    mad_tpsa_vinv    (ssz_t n, const tpsa_t *a[], num_t v, tpsa_t *c[]); // c[i] = v/a[i]
+void    mad_tpsa_vinvsqrt(ssz_t n, const tpsa_t *a[], num_t v, tpsa_t *c[]); // c[i] = v/sqrt(a[i])
+void    mad_tpsa_vsqrt   (ssz_t n, const tpsa_t *a[], tpsa_t *c[]);
+void    mad_tpsa_vexp    (ssz_t n, const tpsa_t *a[], tpsa_t *c[]);
+void    mad_tpsa_vlog    (ssz_t n, const tpsa_t *a[], tpsa_t *c[]);
+void    mad_tpsa_vsin    (ssz_t n, const tpsa_t *a[], tpsa_t *c[]);
+void    mad_tpsa_vcos    (ssz_t n, const tpsa_t *a[], tpsa_t *c[]);
+void    mad_tpsa_vsincos (ssz_t n, const tpsa_t *a[], tpsa_t *s[], tpsa_t *c[]);
+
 // high level functions
 void    mad_tpsa_axpb       (num_t a, const tpsa_t *x,
                              num_t b, tpsa_t *r);
@@ -203,6 +215,7 @@ num_t   mad_tpsa_mnrm     (ssz_t na, const tpsa_t *ma[]);
 void    mad_tpsa_minv     (ssz_t na, const tpsa_t *ma[], ssz_t nb,                     tpsa_t *mc[]);
 void    mad_tpsa_pminv    (ssz_t na, const tpsa_t *ma[], ssz_t nb,                     tpsa_t *mc[], idx_t select[]);
 void    mad_tpsa_compose  (ssz_t na, const tpsa_t *ma[], ssz_t nb, const tpsa_t *mb[], tpsa_t *mc[]);
+void    mad_tpsa_compose_n(ssz_t na, const tpsa_t *ma[], ssz_t nb, ssz_t n,            tpsa_t *mc[]); // ma[n*nb]
 void    mad_tpsa_translate(ssz_t na, const tpsa_t *ma[], ssz_t nb, const num_t   tb[], tpsa_t *mc[]);
 void    mad_tpsa_eval     (ssz_t na, const tpsa_t *ma[], ssz_t nb, const num_t   tb[], num_t   tc[]);
 void    mad_tpsa_mconv    (ssz_t na, const tpsa_t *ma[], ssz_t nc,                     tpsa_t *mc[], ssz_t n, idx_t t2r_[], int pb);
@@ -214,6 +227,13 @@ const
 desc_t* mad_tpsa_scan_hdr (     int *kind_, char  name_[NAMSZ],                  FILE *stream_);
 void    mad_tpsa_scan_coef(      tpsa_t *t,                                      FILE *stream_);
 
+// binary I/O (load from memory, e.g. mapped file)
+void    mad_tpsa_save     (const tpsa_t *t, str_t name_,                         FILE *stream_);
+tpsa_t* mad_tpsa_load     (                      ptr_t buf, size_t len, size_t *pos);
+const
+desc_t* mad_tpsa_load_hdr (     int *kind_, char  name_[NAMSZ], ptr_t buf, size_t len, size_t pos);
+void    mad_tpsa_load_coef(      tpsa_t *t,                     ptr_t buf, size_t len, size_t *pos);
+
 // unsafe operation (mo vs allocated!!)
 tpsa_t* mad_tpsa_init     (      tpsa_t *t, const desc_t *d, ord_t mo);
 
@@ -645,6 +645,54 @@ inline T invsqrt (const T &a, num_t v=1) { TRC("tmp")
 
 #endif // TPSA_USE_TMP
 
+// --- batch ---
+
+// n GTPSAs sharing the same descriptor, aliasing allowed only for a[i] == c[i].
+// num_t versions are provided for kernels templated on particles and damaps.
+
+#define CTA(a) const_cast<const tpsa_t**>(a)
+
+inline void inv (ssz_t n, tpsa_t* const a[], tpsa_t *c[], num_t v=1) { TRC("tpsa[]")
+  mad_tpsa_vinv(n, CTA(a), v, c);
+}
+
+inline void invsqrt (ssz_t n, tpsa_t* const a[], tpsa_t *c[], num_t v=1) { TRC("tpsa[]")
+  mad_tpsa_vinvsqrt(n, CTA(a), v, c);
+}
+
+inline void sincos (ssz_t n, tpsa_t* const a[], tpsa_t *s[], tpsa_t *c[]) { TRC("tpsa[]")
+  mad_tpsa_vsincos(n, CTA(a), s, c);
+}
+
+inline void inv (ssz_t n, const num_t a[], num_t c[], num_t v=1) { TRC("num[]")
+  for (ssz_t i=0; i < n; i++) c[i] = v/a[i];
+}
+
+inline void invsqrt (ssz_t n, const num_t a[], num_t c[], num_t v=1) { TRC("num[]")
+  for (ssz_t i=0; i < n; i++) c[i] = v/std::sqrt(a[i]);
+}
+
+inline void sincos (ssz_t n, const num_t a[], num_t s[], num_t c[]) { TRC("num[]")
+  for (ssz_t i=0; i < n; i++) s[i] = std::sin(a[i]), c[i] = std::cos(a[i]);
+}
+
+#define FUN(F) \
+inline void F (ssz_t n, tpsa_t* const a[], tpsa_t *c[]) { TRC("tpsa[]") \
+  mad_tpsa_v ## F (n, CTA(a), c); \
+} \
+inline void F (ssz_t n, const num_t a[], num_t c[]) { TRC("num[]") \
+  for (ssz_t i=0; i < n; i++) c[i] = std::F(a[i]); \
+}
+
+FUN(sqrt);
+FUN(exp );
+FUN(log );
+FUN(sin );
+FUN(cos );
+
+#undef FUN
+#undef CTA
+
 // --- unary ---
 
 #define FUN(F) \
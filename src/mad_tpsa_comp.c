@@ -22,6 +22,8 @@
 #include "mad_mem.h"
 #ifdef    MAD_CTPSA_IMPL
 #include "mad_ctpsa_impl.h"
+#elif defined(MAD_FTPSA_IMPL)
+#include "mad_ftpsa_impl.h"
 #else
 #include "mad_tpsa_impl.h"
 #endif
@@ -254,10 +256,63 @@ FUN(compose) (ssz_t sa, const T *ma[sa], ssz_t sb, const T *mb[sb], T *mc[sa])
     FUN(copy)(mc_[ia], mc[ia]);
     FUN(del )(mc_[ia]);
   }
+  FOR(ia,sa) FUN(prune0)(mc[ia]);
   mad_free_tmp(mc_);
   DBGFUN(<-);
 }
 
+void //             sa <= nv   ma[n*sb]        sb <= nn
+FUN(compose_n) (ssz_t sa, const T *ma[], ssz_t sb, ssz_t n, T *mc[sa])
+{
+  assert(ma && mc); DBGFUN(->);
+  ensure(n > 0, "invalid number of maps (zero or negative)");
+  FOR(k,n) check_compose(sa, &ma[k*sb], sb, &ma[k*sb], mc, TRUE);
+
+  // maps of the current and next levels, owned maps are intermediate products
+  mad_alloc_tmp(const T*, m0, n*sb);
+  mad_alloc_tmp(const T*, m1, n*sb);
+  mad_alloc_tmp(log_t   , o0, n);
+  mad_alloc_tmp(log_t   , o1, n);
+  memcpy(m0, ma, n*sb*sizeof *m0);
+  memset(o0, 0 , n   *sizeof *o0);
+
+  const T **mp = m0, **mq = m1;
+  log_t    *op = o0,  *oq = o1;
+
+  // tree reduction, mq[j] = mp[2j+1] o mp[2j] (maps are in tracking order)
+  for (ssz_t m = n; m > 1; m = (m+1)/2) {
+    ssz_t h = m/2;
+    #pragma omp parallel for if (h > 1)
+    FOR(j,h) {
+      const T **a = &mp[(2*j+1)*sb], **b = &mp[2*j*sb];
+      T *r[sa];
+      FOR(i,sa) r[i] = FUN(new)(a[i], mad_tpsa_same);
+      FUN(compose)(sa, a, sb, b, r);
+      if (op[2*j  ]) FOR(i,sa) FUN(del)(b[i]);
+      if (op[2*j+1]) FOR(i,sa) FUN(del)(a[i]);
+      FOR(i,sa   ) mq[j*sb+i] = r[i];
+      FOR(i,sa,sb) mq[j*sb+i] = b[i]; // parameters
+      oq[j] = TRUE;
+    }
+    if (m % 2) { // last map moves to next level
+      memcpy(&mq[h*sb], &mp[(m-1)*sb], sb*sizeof *mq);
+      oq[h] = op[m-1];
+    }
+    const T **mt = mp; mp = mq; mq = mt;
+    log_t    *ot = op; op = oq; oq = ot;
+  }
+
+  // save result
+  FOR(i,sa) {
+    FUN(copy)(mp[i], mc[i]);
+    if (op[0]) FUN(del)(mp[i]);
+  }
+
+  mad_free_tmp(m0); mad_free_tmp(m1);
+  mad_free_tmp(o0); mad_free_tmp(o1);
+  DBGFUN(<-);
+}
+
 void
 FUN(translate) (ssz_t sa, const T *ma[sa], ssz_t sb, const NUM tb[sb], T *mc[sa])
 {
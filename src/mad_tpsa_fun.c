@@ -23,8 +23,12 @@
 #include "mad_log.h"
 #include "mad_cst.h"
 #include "mad_num.h"
+#include "mad_mem.h"
 #include "mad_tpsa_impl.h"
 #include "mad_ctpsa_impl.h"
+#ifdef MAD_FTPSA_IMPL
+#include "mad_ftpsa_impl.h"
+#endif
 
 // --- local ------------------------------------------------------------------o
 
@@ -32,23 +36,34 @@
 
 enum { MANUAL_EXPANSION_ORD = 6 };
 
-static inline void
-fun_taylor_h (const T *a, T *c, ord_t n, const NUM ord_coef[n+1])
+static inline ord_t // return lowest order of a-a0 (copied in t) or 0 if null
+fun_taylor0 (const T *a, T *t)
 {
-  assert(a && c && ord_coef);
-  assert(n >= 1); // ord 0 treated outside
+  FUN(copy)(a,t);
+  FUN(seti)(t,0,0,0);             //  a-a0
+  return FUN(nzero0)(t,t->lo,t->hi,1) < 0 ? 0 : t->lo;
+}
 
-  T *acp = GET_TMPX(c);
-  FUN(copy)(a,acp);               // copy of a
-  FUN(seti)(acp,0,0,0);           // (a-a_0)
-  FUN(setval)(c,ord_coef[n]);     // f(a_n)
+static inline void // x = a-a0 with lowest order lo, tmp->mo >= c->mo
+fun_horner (const T *x, ord_t lo, T *c, ord_t n, const NUM ord_coef[n+1], T *tmp)
+{
+  if (!lo) { FUN(setval)(c,ord_coef[0]); return; }
 
-  // Horner's method (slower by 50% - 100% because mul is always full order)
+  T *r = c, *t;
+  ord_t mo = c->mo;
+
+  n = MIN(n, mo/lo);              // (a-a0)^i = 0 for i*lo > mo
+  FUN(setval)(r,ord_coef[n]);     // f(a_n)
+
+  // Horner's method, step n affects only orders <= mo-n*lo of the result
+  // as the partial sum is multiplied by (a-a0)^n afterward
   while (n-- > 0) {
-    FUN(mul)(acp,c,c);            //                    f^(n)(a_n)*(a-a_0)
-    FUN(seti)(c,0,1,ord_coef[n]); // f^(n-1)(a_{n-1}) + f^(n)(a_n)*(a-a_0)
+    FUN(mulord)(x,r,tmp,0,mo-n*lo); //                  f^(n)(a_n)*(a-a0)
+    FUN(seti)(tmp,0,1,ord_coef[n]); // f^(n-1)(a_{n-1}) + f^(n)(a_n)*(a-a0)
+    SWAP(r,tmp,t);
   }
-  REL_TMPX(acp);
+
+  if (r != c) FUN(copy)(r,c);     // enforce result in c
 }
 
 static inline void
@@ -57,35 +72,9 @@ fun_taylor (const T *a, T *c, ord_t n, const NUM ord_coef[n+1])
   assert(a && c && ord_coef);
   assert(n >= 1); // ord 0 treated outside
 
-  T *acp;
-  if (n >= 2) acp = GET_TMPX(c), FUN(copy)(a,acp);
-
-  // n=1
-  FUN(scl)(a, ord_coef[1], c);
-  FUN(seti)(c, 0, 0, ord_coef[0]); // f(a) + f'(a)(a-a0)
-
-  // n=2
-  if (n >= 2) {
-    T *pow = GET_TMPX(c);
-    FUN(seti)(acp,0,0,0);          //  a-a0
-    FUN(mul)(acp,acp,pow);         // (a-a0)^2
-    FUN(acc)(pow,ord_coef[2],c);   // f(a0) + f'(a0)(a-a0) + f"(a0)(a-a0)^2
-
-    // i=3..n
-    if (n >= 3) {
-      T *tmp = GET_TMPX(c), *t;
-
-      for (ord_t i = 3; i <= n; ++i) {
-        FUN(mul)(acp,pow,tmp);
-        FUN(acc)(tmp,ord_coef[i],c); // f(a0) + ... + f^(i)(a0)(a-a0)^i
-        SWAP(pow,tmp,t);
-      }
-
-      if (n & 1) SWAP(pow,tmp,t); // enforce even number of swaps
-      REL_TMPX(tmp);
-    }
-    REL_TMPX(pow), REL_TMPX(acp);
-  }
+  T *acp = GET_TMPX(c), *tmp = GET_TMPX(c);
+  fun_horner(acp, fun_taylor0(a,acp), c, n, ord_coef, tmp);
+  REL_TMPX(tmp), REL_TMPX(acp);
 }
 
 static inline void
@@ -96,38 +85,77 @@ sincos_taylor (const T *a, T *s, T *c,
   assert(a && s && c && sin_coef && cos_coef);
   assert(n_s >= 1 && n_c >= 1);
 
-  ord_t n = MAX(n_s,n_c);
-  T *acp = GET_TMPX(c); FUN(copy)(a,acp);
-
-  // n=1
-  FUN(scl)(acp, sin_coef[1], s); FUN(seti)(s, 0, 0, sin_coef[0]);
-  FUN(scl)(acp, cos_coef[1], c); FUN(seti)(c, 0, 0, cos_coef[0]);
-
-  // n=2
-  if (n >= 2) {
-    T *pow = GET_TMPX(c);
-    FUN(seti)(acp,0,0,0);
-    FUN(mul)(acp,acp,pow);
-    if (n_s >= 2) FUN(acc)(pow,sin_coef[2],s);
-    if (n_c >= 2) FUN(acc)(pow,cos_coef[2],c);
-
-    // i=3..n
-    if (n >= 3) {
-      T *tmp = GET_TMPX(c), *t;
-
-      for (ord_t i = 3; i <= n; ++i) {
-        FUN(mul)(acp,pow,tmp);
-        if (n_s >= i) FUN(acc)(tmp,sin_coef[i],s);
-        if (n_c >= i) FUN(acc)(tmp,cos_coef[i],c);
-        SWAP(pow,tmp,t);
-      }
+  T *m = s->mo >= c->mo ? s : c;
+  T *acp = GET_TMPX(m), *tmp = GET_TMPX(m);
+  ord_t lo = fun_taylor0(a,acp);
+  fun_horner(acp, lo, s, n_s, sin_coef, tmp);
+  fun_horner(acp, lo, c, n_c, cos_coef, tmp);
+  REL_TMPX(tmp), REL_TMPX(acp);
+}
 
-      if (n & 1) SWAP(pow,tmp,t); // enforce even number of swaps
-      REL_TMPX(tmp);
-    }
-    REL_TMPX(pow);
-  }
-  REL_TMPX(acp);
+// --- coefficients of the Taylor series at a0 (to >= 1) ---
+
+static inline void
+coef_inv (NUM a0, ord_t to, NUM ord_coef[to+1])
+{
+  NUM f0 = NUMF(inv)(a0);
+  ord_coef[0] = f0;
+  for (ord_t o = 1; o <= to; ++o)
+    ord_coef[o] = -ord_coef[o-1] * f0;
+}
+
+static inline void
+coef_invsqrt (NUM a0, ord_t to, NUM ord_coef[to+1])
+{
+  NUM _a0 = NUMF(inv)(a0);
+  ord_coef[0] = NUMF(inv)(sqrt(a0));
+  for (ord_t o = 1; o <= to; ++o)
+    ord_coef[o] = -ord_coef[o-1] * _a0 / (2.*o) * (2.*o-1);
+}
+
+static inline void
+coef_sqrt (NUM a0, ord_t to, NUM ord_coef[to+1])
+{
+  NUM _a0 = NUMF(inv)(a0);
+  ord_coef[0] = sqrt(a0);
+  for (ord_t o = 1; o <= to; ++o)
+    ord_coef[o] = -ord_coef[o-1] * _a0 / (2.*o) * (2.*o-3);
+}
+
+static inline void
+coef_exp (NUM a0, ord_t to, NUM ord_coef[to+1])
+{
+  ord_coef[0] = exp(a0);
+  for (ord_t o = 1; o <= to; ++o)
+    ord_coef[o] = ord_coef[o-1] / o;
+}
+
+static inline void
+coef_log (NUM a0, ord_t to, NUM ord_coef[to+1])
+{
+  NUM _a0 = NUMF(inv)(a0);
+  ord_coef[0] = log(a0);
+  ord_coef[1] = _a0;
+  for (ord_t o = 2; o <= to; ++o)
+    ord_coef[o] = -ord_coef[o-1] * _a0 / o * (o-1.);
+}
+
+static inline void
+coef_sin (NUM a0, ord_t to, NUM ord_coef[to+1])
+{
+  ord_coef[0] = sin(a0);
+  ord_coef[1] = cos(a0);
+  for (ord_t o = 2; o <= to; ++o)
+    ord_coef[o] = -ord_coef[o-2] / (o*(o-1.));
+}
+
+static inline void
+coef_cos (NUM a0, ord_t to, NUM ord_coef[to+1])
+{
+  ord_coef[0] =  cos(a0);
+  ord_coef[1] = -sin(a0);
+  for (ord_t o = 2; o <= to; ++o)
+    ord_coef[o] = -ord_coef[o-2] / (o*(o-1.));
 }
 
 // --- public -----------------------------------------------------------------o
@@ -142,7 +170,7 @@ FUN(taylor_h) (const T *a, ssz_t n, const NUM coef[n], T *c)
   ord_t to = MIN(n-1, c->mo);
   if (!to || FUN(isval)(a)) { FUN(setval)(c,coef[0]); DBGFUN(<-); return; }
 
-  fun_taylor_h(a,c,to,coef);
+  fun_taylor(a,c,to,coef);
   DBGFUN(<-);
 }
 
@@ -173,9 +201,7 @@ FUN(inv) (const T *a, NUM v, T *c) // c = v/a    // checked for real and complex
   if (!to || FUN(isval)(a)) { FUN(setval)(c,v*f0); DBGFUN(<-); return; }
 
   NUM ord_coef[to+1];
-  ord_coef[0] = f0;
-  for (ord_t o = 1; o <= to; ++o)
-    ord_coef[o] = -ord_coef[o-1] * f0;
+  coef_inv(a0,to,ord_coef);
 
   fun_taylor(a,c,to,ord_coef);
   if (v != 1) FUN(scl)(c,v,c);
@@ -190,15 +216,12 @@ FUN(invsqrt) (const T *a, NUM v, T *c) // v/sqrt(a),checked for real and complex
   NUM a0 = a->coef[0];
   ensure(SELECT(a0 > 0, a0 != 0), "invalid domain invsqrt("FMT")", VAL(a0));
 
-  NUM _a0 = NUMF(inv)(a0);
-  NUM  f0 = NUMF(inv)(sqrt(a0));
+  NUM f0 = NUMF(inv)(sqrt(a0));
   ord_t to = c->mo;
   if (!to || FUN(isval)(a)) { FUN(setval)(c,v*f0); DBGFUN(<-); return; }
 
   NUM ord_coef[to+1];
-  ord_coef[0] = f0;
-  for (ord_t o = 1; o <= to; ++o)
-    ord_coef[o] = -ord_coef[o-1] * _a0 / (2.*o) * (2.*o-1);
+  coef_invsqrt(a0,to,ord_coef);
 
   fun_taylor(a,c,to,ord_coef);
   if (v != 1) FUN(scl)(c,v,c);
@@ -217,11 +240,8 @@ FUN(sqrt) (const T *a, T *c)                     // checked for real and complex
   ord_t to = c->mo;
   if (!to || FUN(isval)(a)) { FUN(setval)(c,f0); DBGFUN(<-); return; }
 
-  NUM _a0 = NUMF(inv)(a0);
   NUM ord_coef[to+1];
-  ord_coef[0] = f0;
-  for (ord_t o = 1; o <= to; ++o)
-    ord_coef[o] = -ord_coef[o-1] * _a0 / (2.*o) * (2.*o-3);
+  coef_sqrt(a0,to,ord_coef);
 
   fun_taylor(a,c,to,ord_coef);
   DBGFUN(<-);
@@ -232,15 +252,13 @@ FUN(exp) (const T *a, T *c)                      // checked for real and complex
 {
   assert(a && c); DBGFUN(->);
   ensure(IS_COMPAT(a,c), "incompatibles GTPSA (descriptors differ)");
-  NUM f0 = exp(a->coef[0]);
+  NUM a0 = a->coef[0], f0 = exp(a0);
 
   ord_t to = c->mo;
   if (!to || FUN(isval)(a)) { FUN(setval)(c,f0); DBGFUN(<-); return; }
 
   NUM ord_coef[to+1];
-  ord_coef[0] = f0;
-  for (ord_t o = 1; o <= to; ++o)
-    ord_coef[o] = ord_coef[o-1] / o;
+  coef_exp(a0,to,ord_coef);
 
   fun_taylor(a,c,to,ord_coef);
   DBGFUN(<-);
@@ -258,12 +276,8 @@ FUN(log) (const T *a, T *c)                      // checked for real and complex
   ord_t to = c->mo;
   if (!to || FUN(isval)(a)) { FUN(setval)(c,f0); DBGFUN(<-); return; }
 
-  NUM _a0 = NUMF(inv)(a0);
   NUM ord_coef[to+1];
-  ord_coef[0] = f0;
-  ord_coef[1] = _a0;
-  for (ord_t o = 2; o <= to; ++o)
-    ord_coef[o] = -ord_coef[o-1] * _a0 / o * (o-1.);
+  coef_log(a0,to,ord_coef);
 
   fun_taylor(a,c,to,ord_coef);
   DBGFUN(<-);
@@ -339,10 +353,7 @@ FUN(sin) (const T *a, T *c)                      // checked for real and complex
   if (!to || FUN(isval)(a)) { FUN(setval)(c,f0); DBGFUN(<-); return; }
 
   NUM ord_coef[to+1];
-  ord_coef[0] = f0;
-  ord_coef[1] = cos(a0);
-  for (ord_t o = 2; o <= to; ++o)
-    ord_coef[o] = -ord_coef[o-2] / (o*(o-1.));
+  coef_sin(a0,to,ord_coef);
 
   fun_taylor(a,c,to,ord_coef);
   DBGFUN(<-);
@@ -359,10 +370,7 @@ FUN(cos) (const T *a, T *c)                      // checked for real and complex
   if (!to || FUN(isval)(a)) { FUN(setval)(c,f0); DBGFUN(<-); return; }
 
   NUM ord_coef[to+1];
-  ord_coef[0] = f0;
-  ord_coef[1] = -sin(a0);
-  for (ord_t o = 2; o <= to; ++o)
-    ord_coef[o] = -ord_coef[o-2] / (o*(o-1.));
+  coef_cos(a0,to,ord_coef);
 
   fun_taylor(a,c,to,ord_coef);
   DBGFUN(<-);
@@ -683,6 +691,12 @@ FUN(asin) (const T *a, T *c)                     // checked for real and complex
 #ifdef MAD_CTPSA_IMPL
     mad_ctpsa_logaxpsqrtbpcx2(a, I, 1, -1, c);
     mad_ctpsa_scl(c, -I, c);
+#elif defined(MAD_FTPSA_IMPL)
+    tpsa_t *t = GET_TMPR(c);
+    mad_ftpsa_dbl(a, t);
+    mad_tpsa_asin(t, t);
+    mad_ftpsa_flt(t, c);
+    REL_TMPR(t);
 #else
     ctpsa_t *t = GET_TMPC(c);
     mad_ctpsa_cplx(a, NULL, t);
@@ -727,6 +741,12 @@ FUN(acos) (const T *a, T *c)                     // checked for real and complex
 #ifdef MAD_CTPSA_IMPL
     mad_ctpsa_logaxpsqrtbpcx2(a, I, 1, -1, c);
     mad_ctpsa_axpb(I, c, M_PI_2, c);
+#elif defined(MAD_FTPSA_IMPL)
+    tpsa_t *t = GET_TMPR(c);
+    mad_ftpsa_dbl(a, t);
+    mad_tpsa_acos(t, t);
+    mad_ftpsa_flt(t, c);
+    REL_TMPR(t);
 #else
     ctpsa_t *t = GET_TMPC(c);
     mad_ctpsa_cplx(a, NULL, t);
@@ -1161,6 +1181,169 @@ FUN(erfc) (const T *a, T *c)
   DBGFUN(<-);
 }
 
+// --- batch ------------------------------------------------------------------o
+
+typedef void (coef_fun_t)(NUM a0, ord_t to, NUM ord_coef[]);
+
+static inline T* // result with highest order
+check_vfun (ssz_t n, const T *a[n], T *c[n])
+{
+  ensure(n > 0, "invalid batch size (zero or negative size)");
+  T *m = c[0];
+  FOR(i,n) {
+    ensure(IS_COMPAT(a[0],a[i],c[i]), "incompatibles GTPSA (descriptors differ)");
+    if (c[i]->mo > m->mo) m = c[i];
+  }
+#if TPSA_DEBUG // O(n^2), items are processed in any order (parallel)
+  FOR(i,n) FOR(j,n)
+    ensure(i == j || c[i] != a[j], "invalid batch (c[%d] aliases a[%d])", i, j);
+#endif
+  return m;
+}
+
+static inline log_t
+use_vpar (ssz_t n, const D *d, ord_t mo)
+{
+#ifdef _OPENMP // same threshold as mul, each item costs ~mo products
+  return n > 1 && d->pmul && mo >= 4 && n*(d->ord2idx[mo+1]) >= d->pmul;
+#else
+  (void)n, (void)d, (void)mo;
+  return FALSE;
+#endif
+}
+
+static void
+fun_vtaylor (ssz_t n, const T *a[n], T *c[n], NUM v, coef_fun_t *coef)
+{
+  const D *d = a[0]->d;
+  T *m = check_vfun(n,a,c);
+  ord_t mo = m->mo, to = MAX(mo,1);
+
+  // coefficients first, out of the parallel section (domain errors)
+  mad_alloc_tmp(NUM, ord_coef, n*(to+1));
+  FOR(i,n) coef(a[i]->coef[0], to, ord_coef+i*(to+1));
+
+  // temporaries are taken once per thread and shared by its items
+  #pragma omp parallel if (use_vpar(n,d,mo))
+  {
+    T *acp = GET_TMPX(m), *tmp = GET_TMPX(m);
+    #pragma omp for
+    FOR(i,n) {
+      ord_t lo = fun_taylor0(a[i],acp);
+      fun_horner(acp, lo, c[i], c[i]->mo, ord_coef+i*(to+1), tmp);
+      if (v != 1) FUN(scl)(c[i],v,c[i]);
+    }
+    REL_TMPX(tmp), REL_TMPX(acp);
+  }
+  mad_free_tmp(ord_coef);
+}
+
+void
+FUN(vinv) (ssz_t n, const T *a[n], NUM v, T *c[n]) // c[i] = v/a[i]
+{
+  assert(a && c); DBGFUN(->);
+  FOR(i,n) {
+    NUM a0 = a[i]->coef[0];
+    ensure(a0 != 0, "invalid domain inv("FMT")", VAL(a0));
+  }
+  fun_vtaylor(n,a,c,v,coef_inv);
+  DBGFUN(<-);
+}
+
+void
+FUN(vinvsqrt) (ssz_t n, const T *a[n], NUM v, T *c[n]) // c[i] = v/sqrt(a[i])
+{
+  assert(a && c); DBGFUN(->);
+  FOR(i,n) {
+    NUM a0 = a[i]->coef[0];
+    ensure(SELECT(a0 > 0, a0 != 0), "invalid domain invsqrt("FMT")", VAL(a0));
+  }
+  fun_vtaylor(n,a,c,v,coef_invsqrt);
+  DBGFUN(<-);
+}
+
+void
+FUN(vsqrt) (ssz_t n, const T *a[n], T *c[n])
+{
+  assert(a && c); DBGFUN(->);
+  FOR(i,n) {
+    NUM a0 = a[i]->coef[0];
+    ensure(SELECT(a0 > 0, a0 != 0), "invalid domain sqrt("FMT")", VAL(a0));
+  }
+  fun_vtaylor(n,a,c,1,coef_sqrt);
+  DBGFUN(<-);
+}
+
+void
+FUN(vexp) (ssz_t n, const T *a[n], T *c[n])
+{
+  assert(a && c); DBGFUN(->);
+  fun_vtaylor(n,a,c,1,coef_exp);
+  DBGFUN(<-);
+}
+
+void
+FUN(vlog) (ssz_t n, const T *a[n], T *c[n])
+{
+  assert(a && c); DBGFUN(->);
+  FOR(i,n) {
+    NUM a0 = a[i]->coef[0];
+    ensure(SELECT(a0 > 0, a0 != 0), "invalid domain log("FMT")", VAL(a0));
+  }
+  fun_vtaylor(n,a,c,1,coef_log);
+  DBGFUN(<-);
+}
+
+void
+FUN(vsin) (ssz_t n, const T *a[n], T *c[n])
+{
+  assert(a && c); DBGFUN(->);
+  fun_vtaylor(n,a,c,1,coef_sin);
+  DBGFUN(<-);
+}
+
+void
+FUN(vcos) (ssz_t n, const T *a[n], T *c[n])
+{
+  assert(a && c); DBGFUN(->);
+  fun_vtaylor(n,a,c,1,coef_cos);
+  DBGFUN(<-);
+}
+
+void
+FUN(vsincos) (ssz_t n, const T *a[n], T *s[n], T *c[n])
+{
+  assert(a && s && c); DBGFUN(->);
+  const D *d = a[0]->d;
+  T *ms = check_vfun(n,a,s), *mc = check_vfun(n,a,c);
+  T *m  = ms->mo >= mc->mo ? ms : mc;
+#if TPSA_DEBUG
+  FOR(i,n) FOR(j,n)
+    ensure(s[i] != c[j], "invalid batch (s[%d] aliases c[%d])", i, j);
+#endif
+  ord_t mo = m->mo, to = MAX(mo,1);
+
+  mad_alloc_tmp(NUM, ord_coef, 2*n*(to+1));
+  FOR(i,n) {
+    coef_sin(a[i]->coef[0], to, ord_coef+(2*i  )*(to+1));
+    coef_cos(a[i]->coef[0], to, ord_coef+(2*i+1)*(to+1));
+  }
+
+  #pragma omp parallel if (use_vpar(2*n,d,mo))
+  {
+    T *acp = GET_TMPX(m), *tmp = GET_TMPX(m);
+    #pragma omp for
+    FOR(i,n) {
+      ord_t lo = fun_taylor0(a[i],acp);
+      fun_horner(acp, lo, s[i], s[i]->mo, ord_coef+(2*i  )*(to+1), tmp);
+      fun_horner(acp, lo, c[i], c[i]->mo, ord_coef+(2*i+1)*(to+1), tmp);
+    }
+    REL_TMPX(tmp), REL_TMPX(acp);
+  }
+  mad_free_tmp(ord_coef);
+  DBGFUN(<-);
+}
+
 // --- without complex-by-value version ---------------------------------------o
 
 #ifdef MAD_CTPSA_IMPL
@@ -1174,6 +1357,12 @@ void FUN(invsqrt_r) (const T *a, num_t v_re, num_t v_im, T *c)
 void FUN(pown_r) (const T *a, num_t v_re, num_t v_im, T *c)
 { FUN(pown)(a, CPX(v), c); }
 
+void FUN(vinv_r) (ssz_t n, const T *a[n], num_t v_re, num_t v_im, T *c[n])
+{ FUN(vinv)(n, a, CPX(v), c); }
+
+void FUN(vinvsqrt_r) (ssz_t n, const T *a[n], num_t v_re, num_t v_im, T *c[n])
+{ FUN(vinvsqrt)(n, a, CPX(v), c); }
+
 #endif
 
 // --- end --------------------------------------------------------------------o
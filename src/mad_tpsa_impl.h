@@ -39,10 +39,11 @@ struct tpsa_ {  // warning: must be identical to LuaJIT def (see mad_gtpsa.mad)
 
 // --- macros -----------------------------------------------------------------o
 
-#ifndef MAD_CTPSA_IMPL
+#if !defined(MAD_CTPSA_IMPL) && !defined(MAD_FTPSA_IMPL)
 
 #define T                tpsa_t
 #define NUM              num_t
+#define ACC              num_t  // accumulator of products in kernels
 #define NUMF(name)       MKNAME(mad_num_,name)
 #define FUN(name)        MKNAME(mad_tpsa_,name)
 #define PFX(name)        name
@@ -156,6 +157,34 @@ mad_tpsa_nzero0r (const tpsa_t *t, ord_t lo, ord_t hi, log_t upt)
   return -1;
 }
 
+static inline void // prune coefs below thresholds of each order and adjust lo,hi
+mad_tpsa_prune0 (tpsa_t *t)
+{
+  assert(t);
+  const num_t *eps = t->d->prn;
+  if (!eps || t->lo > t->hi) return;    // pruning disabled or scalar
+
+  const idx_t *o2i = t->d->ord2idx;
+  ord_t lo = t->lo, hi = t->hi;
+  long n = 0;
+  for (ord_t o = lo; o <= hi; ++o) {
+    num_t e = eps[o];
+    if (e > 0)
+      for (idx_t i = o2i[o]; i < o2i[o+1]; ++i)
+        if (t->coef[i] && fabs(t->coef[i]) < e) t->coef[i] = 0, ++n;
+  }
+  if (!n) return;
+
+  if (mad_tpsa_nzero0(t,lo,hi,1) >= 0) mad_tpsa_nzero0r(t,t->lo,hi,1);
+
+  desc_t *d = (desc_t*)t->d;
+  num_t no = (hi-lo+1) - (t->lo <= t->hi ? t->hi-t->lo+1 : 0); // dropped orders
+  #pragma omp atomic
+  d->prn_n += n;
+  #pragma omp atomic
+  d->prn_o += no;
+}
+
 // --- temporaries ------------------------------------------------------------o
 
 #if DESC_USE_TMP
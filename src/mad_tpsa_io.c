@@ -24,6 +24,8 @@
 #include "mad_str.h"
 #ifdef    MAD_CTPSA_IMPL
 #include "mad_ctpsa_impl.h"
+#elif defined(MAD_FTPSA_IMPL)
+#include "mad_ftpsa_impl.h"
 #else
 #include "mad_tpsa_impl.h"
 #endif
@@ -441,4 +443,238 @@ hiorders: ;
   DBGFUN(<-);
 }
 
+// --- binary I/O -------------------------------------------------------------o
+
+/* Binary records are written by save and read from memory (e.g. mapped file)
+   by load_hdr and load_coef. Records are 8 bytes aligned and made of:
+   - the header below,
+   - the orders no[nv+np] of the descriptor (padded),
+   - if sparse, the indexes of the coefficients idx[nc] (padded),
+   - the coefficients coef[nc], i.e. if dense, coef[0] then the coefficients
+     from order lo to hi.
+*/
+
+struct bin_hdr {
+  char    mag[4];      // "GTPS"
+  char    knd;         // 'R' or 'C'
+  char    fmt;         // 'D' (dense) or 'S' (sparse)
+  ord_t   lo, hi, mo;  // TPSA orders
+  ord_t   dmo, po, _;  // descriptor orders
+  int32_t nv, np;      // descriptor number of variables and parameters
+  int32_t nc;          // number of coefficients
+  u64_t   key;         // descriptor fingerprint
+  char    nam[NAMSZ];  // TPSA name
+};
+
+#define BIN_PAD(n) (((n)+7) & ~(size_t)7)
+
+static inline u64_t
+bin_key (int nv, ord_t mo, int np, ord_t po, const ord_t no[nv+np])
+{
+  u64_t key = 14695981039346656037ull; // FNV-1a
+#define KEY(v) (key = (key ^ (u64_t)(v)) * 1099511628211ull)
+  KEY(nv), KEY(mo), KEY(np), KEY(np ? po : 0);
+  FOR(i,nv+np) KEY(no[i]);
+#undef  KEY
+  return key;
+}
+
+void
+FUN(save) (const T *t, str_t name_, FILE *stream_)
+{
+  assert(t); DBGFUN(->);
+  if (!name_  ) name_   = t->nam;
+  if (!stream_) stream_ = stdout;
+
+  const D *d = t->d;
+  const idx_t *o2i = d->ord2idx;
+  const idx_t i0 = o2i[t->lo], i1 = t->lo <= t->hi ? o2i[t->hi+1] : i0;
+  const ssz_t nd = 1 + i1-i0;
+
+  // count non-zeros to select dense or sparse format
+  ssz_t nz = t->coef[0] != 0;
+  FOR(i,i0,i1) nz += t->coef[i] != 0;
+  const log_t sp = nz*(sizeof(idx_t)+sizeof(NUM)) < nd*sizeof(NUM);
+
+  struct bin_hdr h = {
+    .mag = "GTPS", .fmt = sp ? 'S' : 'D',
+#ifndef MAD_CTPSA_IMPL
+    .knd = 'R',
+#else
+    .knd = 'C',
+#endif
+    .lo = t->lo, .hi = t->hi, .mo = t->mo, .dmo = d->mo, .po = d->po,
+    .nv = d->nv, .np = d->np, .nc = sp ? nz : nd,
+    .key = bin_key(d->nv, d->mo, d->np, d->po, d->no),
+  };
+  strncpy(h.nam, name_, NAMSZ), h.nam[NAMSZ-1] = 0;
+
+  static const char pad[8] = {0};
+  const size_t nn = d->nn, ni = sp ? nz*sizeof(idx_t) : 0;
+  fwrite(&h  , sizeof h, 1, stream_);
+  fwrite(d->no, 1, nn, stream_);
+  fwrite(pad , 1, BIN_PAD(nn)-nn, stream_);
+
+  if (!sp) { // dense
+    fwrite(t->coef, sizeof(NUM), 1, stream_);
+    fwrite(t->coef+i0, sizeof(NUM), i1-i0, stream_);
+  } else {   // sparse
+    mad_alloc_tmp(idx_t, idx, nz);
+    mad_alloc_tmp(NUM  , val, nz);
+    idx_t k = 0;
+    if (t->coef[0]) idx[k] = 0, val[k++] = t->coef[0];
+    FOR(i,i0,i1) if (t->coef[i]) idx[k] = i, val[k++] = t->coef[i];
+    fwrite(idx, sizeof(idx_t), nz, stream_);
+    fwrite(pad, 1, BIN_PAD(ni)-ni, stream_);
+    fwrite(val, sizeof(NUM), nz, stream_);
+    mad_free_tmp(val);
+    mad_free_tmp(idx);
+  }
+  DBGFUN(<-);
+}
+
+#ifdef MAD_CTPSA_IMPL
+
+extern const D* mad_tpsa_load_hdr(int*, char[NAMSZ], ptr_t, size_t, size_t);
+
+const D*
+FUN(load_hdr) (int *kind_, char name_[NAMSZ], ptr_t buf, size_t len, size_t pos)
+{
+  DBGFUN(->); // complex and real header are the same...
+  const D* ret = mad_tpsa_load_hdr(kind_, name_, buf, len, pos);
+  DBGFUN(<-);
+  return ret;
+}
+
+#else
+
+const D*
+FUN(load_hdr) (int *kind_, char name_[NAMSZ], ptr_t buf, size_t len, size_t pos)
+{
+  assert(buf); DBGFUN(->);
+  struct bin_hdr h;
+  const char *p = (const char*)buf + pos;
+
+  if (pos + sizeof h > len || memcmp(p, "GTPS", 4)) {
+    DBGFUN(<-); return NULL; // not a binary GTPSA record
+  }
+  memcpy(&h, p, sizeof h);
+
+  const int nn = h.nv+h.np;
+  ensure(0 < h.nv && 0 <= h.np && nn <= DESC_MAX_VAR,
+         "invalid NV=%d or NP=%d", h.nv, h.np);
+  ensure(pos + sizeof h + nn <= len, "invalid input (truncated record)");
+  ensure(strchr("RC", h.knd) && strchr("DS", h.fmt),
+         "invalid kind='%c' or format='%c'", h.knd, h.fmt);
+
+  // descriptor from key (nv, mo, np, po, no)
+  ord_t no[nn];
+  memcpy(no, p + sizeof h, nn);
+  ensure(bin_key(h.nv, h.dmo, h.np, h.po, no) == h.key,
+         "invalid GTPSA descriptor fingerprint for '%.*s'", NAMSZ, h.nam);
+  const D *d = mad_desc_newvpo(h.nv, h.dmo, h.np, h.po, no);
+
+  if (kind_) {
+    ensure(*kind_ >= -1 && *kind_ <= 1, "invalid kind (expecting -1, 0, 1)");
+    if (*kind_ == -1) *kind_ = h.knd == 'C';
+    else if (h.knd != "RC"[*kind_])
+      warn("kind specification '%c' differs from input '%c'", "RC"[*kind_], h.knd);
+  }
+
+  if (name_) {
+    memcpy(name_, h.nam, NAMSZ);
+    name_[NAMSZ-1] = '\0';
+  }
+
+  DBGFUN(<-);
+  return d;
+}
+
+#endif // !MAD_CTPSA_IMPL
+
+void
+FUN(load_coef) (T *t, ptr_t buf, size_t len, size_t *pos)
+{
+  assert(t && buf && pos); DBGFUN(->);
+  struct bin_hdr h;
+  const char *p = (const char*)buf + *pos;
+
+  ensure(*pos + sizeof h <= len && !memcmp(p, "GTPS", 4),
+         "invalid input (binary GTPSA record expected)");
+  memcpy(&h, p, sizeof h);
+  h.nam[NAMSZ-1] = '\0';
+
+#ifndef MAD_CTPSA_IMPL
+  ensure(h.knd == 'R', "invalid input (real GTPSA expected)");
+#else
+  ensure(h.knd == 'C', "invalid input (complex GTPSA expected)");
+#endif
+
+  const D *d = t->d;
+  const int nn = h.nv+h.np, nc = h.nc;
+  const size_t ni = h.fmt == 'S' ? nc*sizeof(idx_t) : 0;
+  const size_t no = sizeof h, io = no + BIN_PAD(nn), co = io + BIN_PAD(ni);
+  const size_t sz = co + nc*sizeof(NUM);
+  ensure(*pos + sz <= len, "invalid input (truncated record)");
+  ensure(nn == d->nn, "incompatible GTPSA descriptor for '%.*s'", NAMSZ, h.nam);
+
+  const NUM   *coef = (const NUM  *)(p + co);
+  const idx_t *idx  = (const idx_t*)(p + io);
+  const log_t  same = bin_key(d->nv, d->mo, d->np, d->po, d->no) == h.key;
+  FUN(reset0)(t);
+
+  if (same) { // same descriptor, copy coefficients directly
+    const idx_t *o2i = d->ord2idx;
+    const ord_t hi = MIN(h.hi, t->mo);
+    if (h.fmt == 'D') {
+      t->coef[0] = coef[0];
+      if (h.lo <= hi) {
+        t->lo = h.lo, t->hi = hi;
+        memcpy(t->coef+o2i[h.lo], coef+1, (o2i[hi+1]-o2i[h.lo])*sizeof(NUM));
+      }
+    } else {
+      if (h.lo <= hi) t->lo = h.lo, t->hi = hi, FUN(clear0)(t,h.lo,hi);
+      FOR(k,nc) if (idx[k] < o2i[hi+1]) t->coef[idx[k]] = coef[k];
+    }
+  } else {    // different descriptor, set coefficients through monomials
+    const D *ds = mad_desc_newvpo(h.nv, h.dmo, h.np, h.po, (const ord_t*)(p+no));
+    const idx_t *o2i = ds->ord2idx;
+    if (h.fmt == 'D') {
+      if (coef[0]) FUN(seti)(t,0,0,coef[0]);
+      if (h.lo <= h.hi)
+        FOR(i,o2i[h.lo],o2i[h.hi+1])
+          if (ds->ords[i] <= t->mo && coef[1+i-o2i[h.lo]])
+            FUN(setm)(t,nn,ds->To[i],0,coef[1+i-o2i[h.lo]]);
+    } else {
+      FOR(k,nc)
+        if (ds->ords[idx[k]] <= t->mo && coef[k])
+          FUN(setm)(t,nn,ds->To[idx[k]],0,coef[k]);
+    }
+  }
+
+  *pos += sz;
+  FUN(nam)(t, h.nam);
+  FUN(update)(t);
+  DBGTPSA(t); DBGFUN(<-);
+}
+
+T*
+FUN(load) (ptr_t buf, size_t len, size_t *pos)
+{
+  DBGFUN(->);
+#ifndef MAD_CTPSA_IMPL
+  int knd = 0;
+#else
+  int knd = 1;
+#endif
+  T *t = NULL;
+  const D *d = FUN(load_hdr)(&knd, NULL, buf, len, *pos);
+  if (d) {
+    t = FUN(newd)(d, mad_tpsa_dflt);
+    FUN(load_coef)(t, buf, len, pos);
+  }
+  DBGFUN(<-);
+  return t;
+}
+
 // --- end --------------------------------------------------------------------o
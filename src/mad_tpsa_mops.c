@@ -22,6 +22,8 @@
 #include "mad_mem.h"
 #ifdef    MAD_CTPSA_IMPL
 #include "mad_ctpsa_impl.h"
+#elif defined(MAD_FTPSA_IMPL)
+#include "mad_ftpsa_impl.h"
 #else
 #include "mad_tpsa_impl.h"
 #endif
@@ -20,8 +20,11 @@
 #include "mad_log.h"
 #include "mad_cst.h"
 #include "mad_num.h"
+#include "mad_mem.h"
 #ifdef    MAD_CTPSA_IMPL
 #include "mad_ctpsa_impl.h"
+#elif defined(MAD_FTPSA_IMPL)
+#include "mad_ftpsa_impl.h"
 #else
 #include "mad_tpsa_impl.h"
 #endif
@@ -29,48 +32,47 @@
 // --- multiplication helpers -------------------------------------------------o
 
 static inline void
-hpoly_diag_mul(const NUM *ca, const NUM *cb, NUM *cc, ssz_t nb,
+hpoly_diag_mul(const NUM *ca, const NUM *cb, ACC *cc, ssz_t nb,
                  const idx_t l[], const idx_t *idx[])
 {
   // asymm: c[2 2] = a[2 0]*b[0 2] + a[0 2]*b[2 0]
   FOR(ib,nb) if (cb[ib] || ca[ib])
     FOR(ia, idx[0][ib], idx[1][ib]) {
       idx_t ic = l[hpoly_idx(ib,ia,nb)];
-      if (ic >= 0) cc[ic] += ca[ia]*cb[ib] + (ia != ib)*ca[ib]*cb[ia];
+      if (ic >= 0) cc[ic] += (ACC)ca[ia]*cb[ib] + (ia != ib)*(ACC)ca[ib]*cb[ia];
     }
 }
 
 static inline void
 hpoly_sym_mul(const NUM *ca1, const NUM *cb1, const NUM *ca2, const NUM *cb2,
-              NUM *cc, ssz_t na, ssz_t nb, const idx_t l[], const idx_t *idx[])
+              ACC *cc, ssz_t na, ssz_t nb, const idx_t l[], const idx_t *idx[])
 {
   // na > nb so longer loop is inside
   FOR(ib,nb) if (cb1[ib] || ca2[ib])
     FOR(ia, idx[0][ib], idx[1][ib]) {
       idx_t ic = l[hpoly_idx(ib,ia,na)];
-      if (ic >= 0) cc[ic] += ca1[ia]*cb1[ib] + ca2[ib]*cb2[ia];
+      if (ic >= 0) cc[ic] += (ACC)ca1[ia]*cb1[ib] + (ACC)ca2[ib]*cb2[ia];
     }
 }
 
 static inline void
-hpoly_asym_mul(const NUM *ca, const NUM *cb, NUM *cc, ssz_t na, ssz_t nb,
+hpoly_asym_mul(const NUM *ca, const NUM *cb, ACC *cc, ssz_t na, ssz_t nb,
                const idx_t l[], const idx_t *idx[])
 {
   // oa > ob so longer loop is inside
   FOR(ib,nb) if (cb[ib])
     FOR(ia, idx[0][ib], idx[1][ib]) {
       idx_t ic = l[hpoly_idx(ib,ia,na)];
-      if (ic >= 0) cc[ic] += ca[ia]*cb[ib];
+      if (ic >= 0) cc[ic] += (ACC)ca[ia]*cb[ib];
     }
 }
 
 static inline void
-hpoly_mul(const T *a, const T *b, T *c, const ord_t *ocs, log_t in_parallel)
+hpoly_mul(const T *a, const T *b, T *c, ACC *cc, const ord_t *ocs, log_t in_parallel)
 {
   const D *d = c->d;
   const idx_t *o2i = d->ord2idx;
   const NUM *ca = a->coef, *cb = b->coef;
-  NUM   *cc = c->coef;
   idx_t hod = d->mo/2;
   bit_t nza = mad_bit_mask(~0ull, a->lo, a->hi);
   bit_t nzb = mad_bit_mask(~0ull, b->lo, b->hi);
@@ -124,7 +126,7 @@ hpoly_mul(const T *a, const T *b, T *c, const ord_t *ocs, log_t in_parallel)
 
 #ifdef _OPENMP
 static inline void
-hpoly_mul_par(const T *a, const T *b, T *c) // parallel version
+hpoly_mul_par(const T *a, const T *b, T *c, ACC *cc) // parallel version
 {
   const D *d = c->d;
 
@@ -133,16 +135,16 @@ hpoly_mul_par(const T *a, const T *b, T *c) // parallel version
   FOR(t,d->nth) {
     ord_t i = 0; while (d->ocs[1+t][i] > c->hi+1) ++i;
     // fprintf(stderr, "[t=%d, i=%d, o=%d] ", t, i, d->ocs[1+t][i]);
-    hpoly_mul(a, b, c, &d->ocs[1+t][i], TRUE);
+    hpoly_mul(a, b, c, cc, &d->ocs[1+t][i], TRUE);
   }
   // fprintf(stderr, "\n");
 }
 #endif
 
 static inline void
-hpoly_mul_ser(const T *a, const T *b, T *c) // serial version
+hpoly_mul_ser(const T *a, const T *b, T *c, ACC *cc) // serial version
 {
-  hpoly_mul(a, b, c, &c->d->ocs[0][c->d->mo-c->hi], FALSE);
+  hpoly_mul(a, b, c, cc, &c->d->ocs[0][c->d->mo-c->hi], FALSE);
 }
 
 // --- derivative helpers -----------------------------------------------------o
@@ -336,6 +338,7 @@ FUN(acc) (const T *a, NUM v, T *c)
 #if TPSA_STRICT
   FUN(update)(c);
 #endif
+  FUN(prune0)(c);
   DBGFUN(<-);
 }
 
@@ -351,6 +354,7 @@ FUN(add) (const T *a, const T *b, T *c)
 #if TPSA_STRICT
   FUN(update)(c);
 #endif
+  FUN(prune0)(c);
   DBGFUN(<-);
 }
 
@@ -366,6 +370,7 @@ FUN(sub) (const T *a, const T *b, T *c)
 #if TPSA_STRICT
   FUN(update)(c);
 #endif
+  FUN(prune0)(c);
   DBGFUN(<-);
 }
 
@@ -402,20 +407,22 @@ FUN(axpbypc) (NUM c1, const T *a, NUM c2, const T *b, NUM c3, T *c)
 #if TPSA_STRICT
   FUN(update)(c);
 #endif
+  FUN(prune0)(c);
   DBGFUN(<-);
 }
 
-void
-FUN(mul) (const T *a, const T *b, T *r)
+static inline void // c = a*b restricted to orders [lo,hi]
+mul (const T *a, const T *b, T *r, ord_t lo, ord_t hi)
 {
-  assert(a && b && r); DBGFUN(->);
-  ensure(IS_COMPAT(a,b,r), "incompatibles GTPSA (descriptors differ)");
   const D *d = a->d;
 
-  ord_t chi = MIN(a->hi+b->hi, r->mo);
+  ord_t chi = MIN(a->hi+b->hi, hi, r->mo);
+
+  // orders window is empty
+  if (lo > chi) { FUN(reset0)(r); return; }
 
   // order 0
-  if (!chi) { FUN(setval)(r, a->coef[0]*b->coef[0]); DBGFUN(<-); return; }
+  if (!chi) { FUN(setval)(r, a->coef[0]*b->coef[0]); return; }
 
   T *c = (a == r || b == r) ? GET_TMPX(r) : FUN(reset0)(r);
 
@@ -424,18 +431,34 @@ FUN(mul) (const T *a, const T *b, T *r)
   // order 1+ and linear
   axpbypc(b->coef[0],a,a->coef[0],b,0,c), c->coef[0] *= 0.5;
 
+  // discard orders < lo and > chi of linear part
+  if (lo) {
+    c->coef[0] = 0;
+    if (c->lo < lo) c->lo = lo;
+  }
+  if (c->hi > chi) c->hi = chi;
+  if (c->lo > c->hi) c->lo = 1, c->hi = 0;
+
   // order 2+
   if (chi > 1) {
-    TPSA_SCAN(c,c->hi+1,chi) c->coef[i] = 0;
-    c->lo = MIN(c->lo, a->lo+b->lo, c->mo);
+    ord_t clo = MAX(lo, MIN(c->lo, a->lo+b->lo, c->mo));
+    TPSA_SCAN(c,c->hi ? c->hi+1 : clo,chi) c->coef[i] = 0;
+    c->lo = clo;
     c->hi = chi;
 
-    if (a->hi && b->hi && a->lo == 1 && b->lo == 1) {
+#ifdef MAD_FTPSA_IMPL // accumulate products in double precision
+    mad_alloc_tmp(ACC, cc, o2i[chi+1]);
+    FOR(i,o2i[2],o2i[chi+1]) cc[i] = c->coef[i];
+#else
+    ACC *cc = c->coef;
+#endif
+
+    if (lo <= 2 && a->hi && b->hi && a->lo == 1 && b->lo == 1) {
       const idx_t hod = d->mo/2;
       const idx_t *lc = d->L[hod+1];
       const idx_t *idx[2] = { d->L_idx[hod+1][0], d->L_idx[hod+1][2] };
       assert(lc);
-      hpoly_diag_mul(a->coef+o2i[1], b->coef+o2i[1], c->coef, o2i[2]-o2i[1], lc, idx);
+      hpoly_diag_mul(a->coef+o2i[1], b->coef+o2i[1], cc, o2i[2]-o2i[1], lc, idx);
     }
 
     // order 3+
@@ -450,11 +473,17 @@ FUN(mul) (const T *a, const T *b, T *r)
       if (d->pmul && c->hi >= 8 &&
           (o2i[a->hi+1]-o2i[a->lo]) >= d->pmul &&
           (o2i[b->hi+1]-o2i[b->lo]) >= d->pmul)
-        hpoly_mul_par(a,b,c);
+        hpoly_mul_par(a,b,c,cc);
       else
 #endif
-        hpoly_mul_ser(a,b,c);
+        hpoly_mul_ser(a,b,c,cc);
     }
+
+#ifdef MAD_FTPSA_IMPL
+    FOR(i,o2i[2],o2i[chi+1]) c->coef[i] = cc[i];
+    mad_free_tmp(cc);
+#endif
+
 #if TPSA_STRICT
   }
   FUN(update)(c);
@@ -462,9 +491,27 @@ FUN(mul) (const T *a, const T *b, T *r)
     FUN(update)(c);
   }
 #endif
+  FUN(prune0)(c);
 
   assert(a != c && b != c);
   if (c != r) { FUN(copy)(c,r); REL_TMPX(c); }
+}
+
+void
+FUN(mul) (const T *a, const T *b, T *r)
+{
+  assert(a && b && r); DBGFUN(->);
+  ensure(IS_COMPAT(a,b,r), "incompatibles GTPSA (descriptors differ)");
+  mul(a,b,r,0,r->mo);
+  DBGFUN(<-);
+}
+
+void
+FUN(mulord) (const T *a, const T *b, T *r, ord_t lo, ord_t hi)
+{
+  assert(a && b && r); DBGFUN(->);
+  ensure(IS_COMPAT(a,b,r), "incompatibles GTPSA (descriptors differ)");
+  mul(a,b,r,lo,hi);
   DBGFUN(<-);
 }
 
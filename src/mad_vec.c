@@ -585,6 +585,162 @@ void mad_cvec_kadd (int k, const cpx_t a[], const cpx_t *x[], cpx_t r[], ssz_t n
   }
 }
 
+// --- cvec Faddeeva
+
+#include "mad_erfw.h"
+
+/* Weideman rational approximation of w(z) for Im(z) >= 0 (SIAM J. Numer. Anal.
+   31, 1994), w(z) = 2 p(Z)/(L-iz)^2 + 1/sqrt(pi)/(L-iz), Z = (L+iz)/(L-iz),
+   with p a polynomial of degree N-1. The relative error is uniform over the
+   upper half-plane and only depends on N, hence the accuracy tiers below.
+*/
+
+static const num_t wf_a16[16] = {
+   1.7483958860819617e+00,  1.3622408222719589e+00,  8.8644783020505469e-01,
+   4.6929090090360376e-01,  1.9124172674669487e-01,  5.1822402431611549e-02,
+   3.6825673170918396e-03, -3.8810151890227213e-03, -1.5276597401219681e-03,
+   8.7031584284719390e-05,  2.1071056396550352e-04,  2.1709867932346902e-05,
+  -2.7346404624376273e-05, -5.5842334110192937e-06,  3.9812875751282533e-06,
+   9.9393225363427429e-07
+};
+static const num_t wf_a20[20] = {
+   1.9853009774971668e+00,  1.6232081325119645e+00,  1.1520634115639845e+00,
+   7.0080133103828968e-01,  3.5704125599214176e-01,  1.4575157593250515e-01,
+   4.2984283879017225e-02,  6.0261101950262732e-03, -1.7307240967378153e-03,
+  -1.1928210147636026e-03, -1.6113009692418951e-04,  9.8145818108920157e-05,
+   4.1457517212429413e-05, -5.1111694449174002e-06, -6.4511176116151310e-06,
+  -6.5124341510505699e-08,  9.5209151167757752e-07,  7.4234159905811551e-08,
+  -1.4871913157622664e-07, -1.4742731218484122e-08
+};
+static const num_t wf_a24[24] = {
+   2.1978589365315413e+00,  1.8562864992055401e+00,  1.3948196733791189e+00,
+   9.2570871385886733e-01,  5.3611395357291147e-01,  2.6549639598807706e-01,
+   1.0838723484566723e-01,  3.3723366855315975e-02,  6.2150063629491988e-03,
+  -4.9364269012854077e-04, -7.8166429956235046e-04, -2.0748431511424014e-04,
+   2.4331415462260496e-05,  3.0471066082991750e-05,  4.1394617243333053e-06,
+  -3.0388931842808250e-06, -1.0856475795689208e-06,  2.5682641335789161e-07,
+   1.8738343454072229e-07, -1.9122258888659664e-08, -3.0082823483700770e-08,
+   1.3310454420475185e-09,  4.9048204901506097e-09, -1.5137461311089544e-10
+};
+static const num_t wf_a28[28] = {
+   2.3921949179131277e+00,  2.0682267636805687e+00,  1.6183171034366732e+00,
+   1.1408377396844427e+00,  7.1934247211920233e-01,  4.0115369944594559e-01,
+   1.9433066813569283e-01,  7.9279989277449711e-02,  2.5594819249886984e-02,
+   5.5042414836779571e-03,  1.2947374409694680e-04, -4.6026819240193461e-04,
+  -1.7784986428834453e-04, -1.0142880051478784e-05,  1.6544544612245946e-05,
+   5.6363851115731650e-06, -6.2086210486034886e-07, -8.4139893707730103e-07,
+  -8.1885985997960793e-08,  9.9353564979713258e-08,  2.6033326040238171e-08,
+  -1.0964156438827034e-08, -4.9925654039031874e-09,  1.2362554037109771e-09,
+   8.5765009806452254e-10, -1.5628686388941984e-10, -1.4438436396265748e-10,
+   2.4291811539657342e-11
+};
+static const num_t wf_a32[32] = {
+   2.5722534081245692e+00,  2.2635372999002676e+00,  1.8256696296324813e+00,
+   1.3455441692345451e+00,  9.0192548936479999e-01,  5.4601397206393421e-01,
+   2.9544451071508732e-01,  1.4060716226893785e-01,  5.7304403529837192e-02,
+   1.9006155784845477e-02,  4.5195411053492859e-03,  3.9259136070078963e-04,
+  -2.4532980270018114e-04, -1.3075449254609857e-04, -2.1409619201818320e-05,
+   6.8210319440006152e-06,  4.4015317315303461e-06,  4.2558331373548059e-07,
+  -4.1840763711854518e-07, -1.4813078917944938e-07,  2.2930439030863583e-08,
+   2.3797556704946969e-08,  8.1248891738117203e-10, -3.2080152204310426e-09,
+  -5.2310221149818974e-10,  4.1537422851859703e-10,  1.1658238510101584e-10,
+  -5.5442474365752472e-11, -2.1543623533433566e-11,  8.0303941532290434e-12,
+   3.7410343481303739e-12, -1.3033482316112991e-12
+};
+static const num_t wf_a36[36] = {
+   2.7407450274098601e+00,  2.4453784928519209e+00,  2.0193976436113505e+00,
+   1.5401625788153654e+00,  1.0813580371765890e+00,  6.9566219189710032e-01,
+   4.0734241895033430e-01,  2.1501636320107409e-01,  1.0084293371847967e-01,
+   4.1051043016577089e-02,  1.3898253763251473e-02,  3.5484447086995613e-03,
+   4.6290316939981749e-04, -1.1396630644463280e-04, -8.8177971418635452e-05,
+  -2.1741186565527124e-05,  1.4187058478743102e-06,  2.7654086657435685e-06,
+   6.7416556638220929e-07, -1.2894842920256469e-07, -1.1303157194272573e-07,
+  -1.0962277865472176e-08,  1.1883887267397132e-08,  3.7734431236965217e-09,
+  -9.0922383494523941e-10, -6.6348471726243057e-10,  3.1971919418286246e-11,
+   9.9393180112953547e-11,  6.3462718401030417e-12, -1.4312519391474000e-11,
+  -2.1170682869685880e-12,  2.0980451134510157e-12,  4.4316190570614782e-13,
+  -3.2388646608556721e-13, -8.0462976098924432e-14,  5.3563903573311345e-14
+};
+
+static const struct {
+  num_t err, L; int n; const num_t *a;
+} wf_tier[] = { // ordered by increasing accuracy
+  { 5e-07, 3.3635856610148581, 16, wf_a16 },
+  { 2e-08, 3.7606030930863934, 20, wf_a20 },
+  { 5e-10, 4.1195342878142354, 24, wf_a24 },
+  { 2e-11, 4.4496055862540596, 28, wf_a28 },
+  { 4e-13, 4.7568284600108841, 32, wf_a32 },
+  { 1e-13, 5.0453784915222872, 36, wf_a36 },
+};
+
+enum { wf_blk = 256 };
+
+static void
+cvec_wf_blk (const cpx_t x[], cpx_t r[], ssz_t n, num_t relerr, int t)
+{
+  const num_t isqpi = 0.56418958354775628694807945156; // 1/sqrt(pi)
+  idx_t iv[wf_blk], is[wf_blk];
+  num_t ur[wf_blk], ui[wf_blk], zr[wf_blk], zi[wf_blk], pr[wf_blk], pi[wf_blk];
+  ssz_t nv = 0, ns = 0;
+
+  // branch-free partition: the upper half-plane goes to the rational kernel,
+  // the lower half-plane (and overflowing |z|) to the scalar Faddeeva_w.
+  FOR(i,n) {
+    num_t re = creal(x[i]), im = cimag(x[i]);
+    int m = (t >= 0) & (im >= 0) & (fabs(re)+im < 1e150);
+    iv[nv] = i; nv += m;
+    is[ns] = i; ns += !m;
+  }
+
+  if (nv) {
+    const num_t L = wf_tier[t].L, *a = wf_tier[t].a;
+    const int   N = wf_tier[t].n;
+
+    // u = 1/(L-iz), Z = (L+iz) u, p = a[N-1]
+    FOR(k,nv) {
+      num_t re = creal(x[iv[k]]), im = cimag(x[iv[k]]);
+      num_t dr = L+im, di = -re, s = 1/(dr*dr + di*di);
+      num_t nr = L-im, ni =  re;
+      ur[k] = dr*s, ui[k] = -di*s;
+      zr[k] = nr*ur[k] - ni*ui[k];
+      zi[k] = nr*ui[k] + ni*ur[k];
+      pr[k] = a[N-1], pi[k] = 0;
+    }
+
+    // Horner scheme, vectorized across points
+    RFOR(j,N-1) FOR(k,nv) {
+      num_t tr = pr[k]*zr[k] - pi[k]*zi[k] + a[j];
+      pi[k] = pr[k]*zi[k] + pi[k]*zr[k];
+      pr[k] = tr;
+    }
+
+    // w = (2 p u + 1/sqrt(pi)) u
+    FOR(k,nv) {
+      num_t qr = 2*(pr[k]*ur[k] - pi[k]*ui[k]) + isqpi;
+      num_t qi = 2*(pr[k]*ui[k] + pi[k]*ur[k]);
+      r[iv[k]] = CPX(qr*ur[k] - qi*ui[k], qr*ui[k] + qi*ur[k]);
+    }
+  }
+
+  FOR(k,ns) r[is[k]] = Faddeeva_w(x[is[k]], relerr);
+}
+
+void mad_cvec_wf (const cpx_t x[], cpx_t r[], ssz_t n, num_t relerr)
+{
+  CHKXR;
+  // select the cheapest tier meeting relerr, none means full scalar precision
+  int t = -1;
+  FOR(i,(int)(sizeof wf_tier/sizeof *wf_tier))
+    if (relerr >= wf_tier[i].err) { t = i; break; }
+
+  // scalar fallback in full precision when a tier is used to honour relerr
+  if (t >= 0) relerr = 0;
+
+  #pragma omp parallel for if (n >= 4*wf_blk)
+  FOR(i,0,n,wf_blk)
+    cvec_wf_blk(x+i, r+i, MIN(n-i, wf_blk), relerr, t);
+}
+
 // --- ivec
 
 log_t mad_ivec_isnul (const idx_t x[], ssz_t n)
@@ -133,6 +133,7 @@ void  mad_cvec_ifft  (const cpx_t x[],                         cpx_t r[], ssz_t
 void  mad_cvec_irfft (const cpx_t x[],                         num_t r[], ssz_t n); // cvec -> vec
 void  mad_cvec_infft (const cpx_t x[], const num_t r_node[],   cpx_t r[], ssz_t n, ssz_t nx);
 void  mad_cvec_kadd  (int k,const cpx_t a[], const cpx_t *x[], cpx_t r[], ssz_t n); // sum_k ax
+void  mad_cvec_wf    (const cpx_t x[],                         cpx_t r[], ssz_t n, num_t relerr); // w(cvec_i)
 
 void  mad_ivec_fill  (      idx_t x  ,                         idx_t r[], ssz_t n); // idx ->ivec
 void  mad_ivec_roll  (      idx_t x[],                                    ssz_t n, int nroll);
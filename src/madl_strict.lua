@@ -12,6 +12,8 @@ local IGNORED_READS  = {
 local MT = {
   __index = function (table, key)
     if IGNORED_READS[key] then return end
+    local lazy = IGNORED_EXTRAS and IGNORED_EXTRAS[key]
+    if type(lazy) == "function" then return lazy(key) end -- lazy global
     local info = debug.getinfo(2, "Sl")
     MAD.warn("%s:%s: attempt to read undeclared global variable: %s\n",
              tostring(info.short_src), tostring(info.currentline), key)
@@ -43,6 +45,9 @@ local function strict_unset ()
   if mt ~= nil and mt ~= MT then
     error("invalid global metatable (i.e. not set by strict)")
   end
+  for k,v in pairs(IGNORED_EXTRAS or {}) do -- resolve lazy globals
+    if type(v) == "function" and rawget(_G,k) == nil then v(k) end
+  end
   setmetatable(_G, nil)
   IGNORED_EXTRAS, STRICTMODE = nil, false
   require = require_orig
@@ -2,7 +2,7 @@ import struct, os, subprocess, sys, select
 from typing import Union, Callable, Any
 import numpy as np
 
-__all__ = ["mad_process"]
+__all__ = ["mad_process", "read_mtb"]
 
 
 def is_not_private(varname):
@@ -404,3 +404,79 @@ type_str = {
   np.dtype("ubyte")       : "mono",
 }
 # ---------------------------------------------------------------------------- #
+
+
+# Binary mtable -------------------------------------------------------------- #
+
+# see mtable writebin and readbin in madl_mtable.mad for the file layout
+
+
+def mtb_unquote(s: str) -> str:
+  if len(s) >= 2 and s[0] == s[-1] and s[0] in "\"'":
+    return s[1:-1].replace('\\"', '"').replace("\\\\", "\\")
+  return s
+
+
+def mtb_value(s: str):
+  if s == "nil":
+    return None
+  if s in ("true", "false"):
+    return s == "true"
+  try:
+    return float(s)
+  except ValueError:
+    return mtb_unquote(s)
+
+
+def read_mtb(filename: str, columns: list = None):
+  """Map a binary mtable file written by MAD (see mtable writebin) and return
+  the header as a dict and the columns as a dict. Numeric columns are numpy
+  arrays mapped onto the file (read-only, no copy), the others are lists."""
+  if not filename.endswith(".mtb"):
+    filename += ".mtb"
+
+  buf = np.memmap(filename, dtype=np.uint8, mode="r")
+  hdr = buf[:64].view(np.uint64)
+  if bytes(buf[:8]) != b"MADMTB\0\0" or hdr[1] != 1 or hdr[7] != len(buf):
+    raise ValueError(f"invalid MTable binary file '{filename}'")
+  nrow, ncol, hpos, hlen, dpos = (int(x) for x in hdr[2:7])
+
+  # text header
+  header, names = {}, []
+  for line in bytes(buf[hpos : hpos + hlen]).decode("utf-8").splitlines():
+    tok = line.split(None, 3)
+    if not tok:
+      continue
+    if tok[0] == "@" and len(tok) == 4:
+      typ, val = tok[2][-1], tok[3]
+      if typ == "s":
+        val = mtb_unquote(val)
+      elif typ in "ef":
+        val = float(val)
+      elif typ == "b":
+        val = val == "true"
+      elif typ == "n":
+        val = None
+      header[tok[1]] = val
+    elif tok[0] == "*":
+      names = line.split()[1:]
+
+  # columns
+  cdir = buf[dpos : dpos + 32 * ncol].view(np.uint64).reshape(ncol, 4)
+  cols = {}
+  for i, name in enumerate(names):
+    if columns is not None and name not in columns:
+      continue
+    typ, pos, siz, blb = (int(x) for x in cdir[i])
+    if typ == 1:
+      cols[name] = buf[pos : pos + siz].view(np.float64)
+    elif typ == 2:
+      cols[name] = buf[pos : pos + siz].view(np.complex128)
+    elif typ in (3, 4):
+      off = buf[pos : pos + 8 * (nrow + 1)].view(np.uint64)
+      dat = bytes(buf[blb : blb + int(off[-1])])
+      val = [dat[off[j] : off[j + 1]].decode("utf-8") for j in range(nrow)]
+      cols[name] = val if typ == 3 else [mtb_value(v) for v in val]
+    else:
+      raise ValueError(f"invalid MTable binary file '{filename}' (column type {typ})")
+  return header, cols